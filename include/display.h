@@ -44,8 +44,10 @@
 #define EPD_BYTE_WIDTH (EPD_WIDTH / BITS_PER_BYTE)
 #define EPD_HEIGHT 480
 
-/* Clock coordinates for display */
+/* Clock coordinates for display, and the HH:MM the ULP redraws every minute */
 #define CLOCK_X 432
 #define CLOCK_Y 100
+#define CLOCK_WIDTH (5 * 48)
+#define CLOCK_HEIGHT 85
 
 #endif
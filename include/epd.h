@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "display.h"
+#include "epd_bus.h"
+
+#ifndef EPD_H
+#define EPD_H
+
+/* Display driver for the Waveshare 7.5" V2 panel, all traffic goes through the bus passed to epd_init() */
+
+/* Frames are rendered and sent a band of rows at a time, so only two bands need to be held in memory */
+#define EPD_BAND_HEIGHT 40
+#define EPD_BAND_SIZE   (EPD_BAND_HEIGHT * EPD_BYTE_WIDTH)
+#define EPD_BANDS       (EPD_HEIGHT / EPD_BAND_HEIGHT)
+
+typedef struct
+{
+    uint16_t x; // Partial windows are addressed in whole bytes, so x and width are multiples of 8
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+} epd_rect_t;
+
+/* Fills a zeroed band buffer with rows [top, top + EPD_BAND_HEIGHT) of the frame */
+typedef void (*epd_band_renderer_t)(uint8_t *band, int top);
+
+/* Fast refresh uses a shorter waveform, quicker but leaves more ghosting than the default one */
+esp_err_t epd_init(const epd_bus_t *bus, bool fast_refresh);
+void epd_clear(void);
+void epd_write_frame(const uint8_t *frame, size_t size);
+void epd_write_banded(epd_band_renderer_t render);
+/* Sends only the given windows of the frame, then refreshes their bounding box once */
+void epd_write_partial(const epd_rect_t *rects, int count, epd_band_renderer_t render);
+esp_err_t epd_sleep(void); // Powers the panel off and releases the bus
+
+#endif
@@ -0,0 +1,95 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "display.h"
+
+#ifndef EPD_BITBANG_H
+#define EPD_BITBANG_H
+
+/* Bit-banged SPI shared by the main CPU's GPIO bus and the ULP, both of which drive the same RTC pins.
+ * The includer defines EPD_GPIO_WRITE(pin, level) for whatever GPIO API it has available, and can
+ * optionally define EPD_BITBANG_BYTE_HOOK() to count bytes as they are clocked out.
+ * EPD_GPIO_SET(pin) and EPD_GPIO_CLEAR(pin) can be defined as single register writes where the GPIO API
+ * is slower than that, they are what MOSI and SCK are clocked with. */
+#ifndef EPD_GPIO_WRITE
+#error "EPD_GPIO_WRITE(pin, level) must be defined before including epd_bitbang.h"
+#endif
+
+#ifndef EPD_GPIO_SET
+#define EPD_GPIO_SET(pin) EPD_GPIO_WRITE(pin, HIGH)
+#endif
+#ifndef EPD_GPIO_CLEAR
+#define EPD_GPIO_CLEAR(pin) EPD_GPIO_WRITE(pin, LOW)
+#endif
+
+#ifndef EPD_BITBANG_BYTE_HOOK
+#define EPD_BITBANG_BYTE_HOOK()
+#endif
+
+/* The panel samples MOSI on the rising edge of SCK */
+#define EPD_BITBANG_WRITE_BIT(byte, mask) \
+    do \
+    { \
+        if ((byte) & (mask)) \
+        { \
+            EPD_GPIO_SET(MOSI_PIN); \
+        } else { \
+            EPD_GPIO_CLEAR(MOSI_PIN); \
+        } \
+        EPD_GPIO_SET(SCK_PIN); \
+        EPD_GPIO_CLEAR(SCK_PIN); \
+    } while (0)
+
+/* Unrolled, it is the inner loop of every transfer */
+static inline void epd_bitbang_write_byte(uint8_t byte)
+{
+    EPD_BITBANG_WRITE_BIT(byte, 0x80);
+    EPD_BITBANG_WRITE_BIT(byte, 0x40);
+    EPD_BITBANG_WRITE_BIT(byte, 0x20);
+    EPD_BITBANG_WRITE_BIT(byte, 0x10);
+    EPD_BITBANG_WRITE_BIT(byte, 0x08);
+    EPD_BITBANG_WRITE_BIT(byte, 0x04);
+    EPD_BITBANG_WRITE_BIT(byte, 0x02);
+    EPD_BITBANG_WRITE_BIT(byte, 0x01);
+    EPD_BITBANG_BYTE_HOOK();
+}
+
+static inline void epd_bitbang_write_command(uint8_t command)
+{
+    EPD_GPIO_WRITE(DC_PIN, LOW); // Command mode
+    EPD_GPIO_WRITE(CS_PIN, LOW);
+    epd_bitbang_write_byte(command);
+    EPD_GPIO_WRITE(CS_PIN, HIGH);
+}
+
+static inline void epd_bitbang_write_data(uint8_t data)
+{
+    EPD_GPIO_WRITE(DC_PIN, HIGH); // Data mode
+    EPD_GPIO_WRITE(CS_PIN, LOW);
+    epd_bitbang_write_byte(data);
+    EPD_GPIO_WRITE(CS_PIN, HIGH);
+}
+
+/* A burst keeps CS low and DC high from epd_bitbang_begin_data() to epd_bitbang_end_data(), with any
+ * number of bytes clocked out by epd_bitbang_write_byte() in between as one transaction */
+static inline void epd_bitbang_begin_data(void)
+{
+    EPD_GPIO_WRITE(DC_PIN, HIGH); // Data mode
+    EPD_GPIO_WRITE(CS_PIN, LOW);
+}
+
+static inline void epd_bitbang_end_data(void)
+{
+    EPD_GPIO_WRITE(CS_PIN, HIGH);
+}
+
+static inline void epd_bitbang_write_burst(const uint8_t *data, size_t length)
+{
+    epd_bitbang_begin_data();
+    for (size_t i = 0; i < length; i++)
+    {
+        epd_bitbang_write_byte(data[i]);
+    }
+    epd_bitbang_end_data();
+}
+
+#endif
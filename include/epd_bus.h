@@ -0,0 +1,60 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifndef EPD_BUS_H
+#define EPD_BUS_H
+
+/* Everything the display driver needs from the wires, so the same command sequences can run over
+ * bit-banged GPIO, hardware SPI, or be recorded on the host */
+typedef struct
+{
+    const char *name;
+    esp_err_t (*init)(void);
+    esp_err_t (*release)(void); // Must leave the pins on RTC GPIO for the ULP
+    void (*write_command)(uint8_t command);
+    void (*write_data)(const uint8_t *data, size_t length);
+    /* Starts sending without waiting for completion where the bus can, data must stay valid until flush() */
+    void (*queue_data)(const uint8_t *data, size_t length);
+    void (*flush)(void);
+    void (*wait_until_idle)(void);
+    void (*reset)(void);
+} epd_bus_t;
+
+#define EPD_BUSY_TIMEOUT_MS  30000 // Full refresh takes a few seconds, anything past this means the panel is stuck
+#define EPD_BUSY_HISTORY     8 // Number of busy waits whose duration is kept
+
+/* Traffic counters, reset by each bus' init so they cover one wake's worth of refreshes */
+typedef struct
+{
+    uint32_t commands;
+    uint32_t data_bytes;
+    uint32_t transactions; // Number of times CS was asserted
+    uint32_t dc_toggles;
+    uint32_t busy_waits;
+    uint32_t busy_timeouts;
+    uint32_t busy_total_ms;
+    uint32_t busy_ms[EPD_BUSY_HISTORY]; // Duration of the first EPD_BUSY_HISTORY waits, in order
+} epd_bus_stats_t;
+
+extern epd_bus_stats_t epd_bus_stats;
+
+extern const epd_bus_t epd_bus_gpio; // Bit-banged over RTC GPIO, same as the ULP
+extern const epd_bus_t epd_bus_spi;  // GPSPI2 with DMA, see epd_spi.h
+
+#if defined(__linux__)
+/* Writes the command/data stream to a text trace, one command per line followed by its data bytes:
+ *     C 06
+ *     D 17 17 27 17
+ * Busy waits and resets are recorded as W and R lines so the ordering against data is visible too */
+extern const epd_bus_t epd_bus_trace;
+
+void epd_bus_trace_set_path(const char *path);
+/* Pin level decoder for code that bit-bangs directly, e.g. the ULP built with
+ * EPD_GPIO_WRITE(pin, level) defined as epd_bus_trace_gpio_write(pin, level) */
+void epd_bus_trace_gpio_write(int pin, int level);
+#endif
+
+void epd_bus_log_stats(const char *label);
+
+#endif
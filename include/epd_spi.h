@@ -0,0 +1,35 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "display.h"
+
+#ifndef EPD_SPI_H
+#define EPD_SPI_H
+
+/* Hardware SPI transport for the display, uses GPSPI2 with DMA so whole rows can be sent per transaction.
+ * The MOSI, SCK, CS and DC pins are taken from RTC GPIO by epd_spi_init() and must be handed back with
+ * epd_spi_release() before deep sleep, otherwise the ULP can't drive them. */
+
+#define EPD_SPI_CLOCK_HZ           (10 * 1000 * 1000) // 100ns minimum write cycle from the datasheet
+#define EPD_SPI_ROWS_PER_TRANSFER  60 // S3 caps a single DMA transaction at 32KB, so the frame is split up
+#define EPD_SPI_MAX_TRANSFER       (EPD_SPI_ROWS_PER_TRANSFER * EPD_BYTE_WIDTH)
+#define EPD_SPI_QUEUE_DEPTH        2
+
+esp_err_t epd_spi_init(void);
+esp_err_t epd_spi_release(void);
+void epd_spi_write_command(uint8_t command);
+void epd_spi_write_data(const uint8_t *data, size_t length);
+/* Queued data is sent in the background, the buffer must be left untouched until epd_spi_flush() returns */
+void epd_spi_queue_data(const uint8_t *data, size_t length);
+void epd_spi_flush(void);
+
+#if defined(__linux__)
+/* Host mock records every byte sent instead of driving the bus, commands are flagged with EPD_SPI_MOCK_COMMAND */
+#define EPD_SPI_MOCK_COMMAND 0x100
+
+const uint16_t *epd_spi_mock_stream(size_t *length);
+size_t epd_spi_mock_transactions(void);
+void epd_spi_mock_reset(void);
+#endif
+
+#endif
@@ -0,0 +1,24 @@
+#include <stdint.h>
+
+#ifndef FIXED_MATH_H
+#define FIXED_MATH_H
+
+/* Integer replacements for the double precision math used for drawing and the battery, which the S3 can
+ * only do in software. Q15 values are fractions scaled by FIXED_Q15_ONE */
+
+#define FIXED_Q15_SHIFT 15
+#define FIXED_Q15_ONE   (1 << FIXED_Q15_SHIFT)
+
+int32_t fixed_sin(int degrees);
+int32_t fixed_cos(int degrees);
+/* numerator / denominator rounded half away from zero, the same as round() */
+int32_t fixed_div_round(int32_t numerator, int32_t denominator);
+/* Maps value from [in_min, in_max] onto [0, out_span], rounded */
+int32_t fixed_map(int32_t value, int32_t in_min, int32_t in_max, int32_t out_span);
+/* Arrow of the given length from (x, y), degrees clockwise from pointing up: its tip in points[0], where the
+ * line ends too, and the other two corners of its head in points[1] and points[2] */
+void fixed_arrow(int x, int y, int degrees, int length, int points[3][2]);
+/* Percentage left in a LiPo cell at the given voltage, clamped to 0-100 */
+uint8_t fixed_battery_percentage(uint32_t millivolts);
+
+#endif
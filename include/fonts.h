@@ -3,12 +3,23 @@
 #ifndef FONTS_H
 #define FONTS_H
 
+/* Font tables in src/fonts.c aren't built into the firmware as is, tools/font_pack.py drops the blank
+ * rows above and below each glyph at build time and the rows left are blitted straight from flash */
+typedef struct
+{
+    uint16_t offset;   // Start of the glyph's rows in the font's table
+    uint8_t first_row; // Rows above this are blank
+    uint8_t rows;      // Number of rows stored, rows below these are blank
+} font_glyph_t;
+
 /* Fonts are ASCII encoded to allow for easier character lookup */
 typedef struct
 {
     const int width;
     const int height;
     const uint8_t *table;
+    const font_glyph_t *glyphs; // Indexed by character - ' '
+    const uint8_t *rotated_table; // Turned 90 degrees anticlockwise by tools/font_rotate.py, NULL if not generated
 } font_t;
 
 extern font_t font12;
@@ -18,24 +29,27 @@ extern font_t font24;
 extern font_t font40;
 extern font_t font60;
 
+/* Generated at build time, see src/CMakeLists.txt */
+extern const uint8_t font12_table_rotated[];
+
 /* Font60 only has 0-9, :, A, P, M for time display to save space
- * Thus isn't ASCII encoded, and the offsets need to be defined manually */
+ * Thus isn't ASCII encoded, and the glyph indices need to be defined manually */
 enum
 {
-    ONE      = 0,
-    TWO      = 510,
-    THREE    = 1020,
-    FOUR     = 1530,
-    FIVE     = 2040,
-    SIX      = 2550,
-    SEVEN    = 3060,
-    EIGHT    = 3570,
-    NINE     = 4080,
-    ZERO     = 4590,
-    COLON    = 5100,
-    LETTER_A = 5610,
-    LETTER_P = 6120,
-    LETTER_M = 6630,
+    ONE = 0,
+    TWO,
+    THREE,
+    FOUR,
+    FIVE,
+    SIX,
+    SEVEN,
+    EIGHT,
+    NINE,
+    ZERO,
+    COLON,
+    LETTER_A,
+    LETTER_P,
+    LETTER_M
 };
 
 #endif
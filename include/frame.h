@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_err.h"
+#include "frame_damage.h"
+
+#ifndef FRAME_H
+#define FRAME_H
+
+/* Draws the weather frame a band at a time for the display code. Nothing in here touches the hardware,
+ * so the same code also builds for the host, see tools/frame_preview */
+
+/* Weather id definitions */
+enum
+{
+    THUNDERSTORM_START = 200,
+    THUNDERSTORM_END   = 232,
+    DRIZZLE_START      = 300,
+    DRIZZLE_END        = 321,
+    RAIN_START         = 500,
+    RAIN_END           = 531,
+    SNOW_START         = 600,
+    SNOW_END           = 622,
+    ATMOSPHERE_START   = 701,
+    ATMOSPHERE_END     = 781,
+    CLEAR_SKY          = 800,
+    CLOUDS_START       = 801,
+    CLOUDS_END         = 804
+};
+
+struct weather_today
+{
+    uint16_t id;
+    char description[32];
+    float current_temp;
+    float feels_like_temp;
+    float high_temp;
+    float low_temp;
+    float wind_speed;
+    uint16_t wind_direction_degrees; // Degrees from north that the wind is coming from
+    float cloudiness; // % of sky covered by clouds
+};
+
+#define FORECAST_HOURS 12
+struct hourly_forecast
+{
+    float temp;
+    float precipitation_chance;
+    char time[6]; // "%Ip" Datetime string
+};
+
+#define FORECAST_DAYS 8 // First item is current day, next 7 are forecast for next 7 days
+struct weather_forecast
+{
+    uint16_t id;
+    float high_temp;
+    float low_temp;
+    float precipitation_chance;
+    char day[10]; // "%A" Datetime string
+};
+
+/* Inputs the frame is drawn from, defined by the application. They must not change between
+ * frame_record_default() and the last band being rendered */
+extern struct tm timeinfo;
+extern uint8_t battery_percentage;
+extern struct weather_today weather;
+extern struct hourly_forecast hourly_forecast[FORECAST_HOURS];
+extern struct weather_forecast forecast[FORECAST_DAYS];
+
+/* Runs the drawing code without rasterizing to record what it draws and which regions of the frame have
+ * anything in them */
+void frame_record_default(void);
+/* Renders one band of the recorded frame into a zeroed buffer, an epd_band_renderer_t. Safe to call for
+ * different bands from two tasks at once */
+void frame_render_default(uint8_t *buffer, int top);
+/* Renders one band of a message centred on an otherwise blank screen */
+void frame_render_message(uint8_t *buffer, int top, const char *message);
+
+/* Hashes every widget's inputs and collects the bounds of the ones that changed since the display was drawn,
+ * both where they drew then and where frame_record_default() recorded them drawing now, so it has to be
+ * called after that. Returns NULL when it isn't known what the display shows */
+const frame_damage_t *widget_check_inputs(void);
+/* Called once the frame is on the display */
+void widget_commit_inputs(void);
+/* Called when something else has been drawn over the widgets */
+void widget_invalidate_inputs(void);
+
+#if defined(FRAME_BENCHMARK)
+/* Times every drawing primitive and the whole frame, logs the results and writes them to results as CSV */
+esp_err_t frame_benchmark(FILE *results);
+#endif
+
+#endif
@@ -0,0 +1,23 @@
+#include <stdint.h>
+#include "display.h"
+
+#ifndef FRAME_CHROME_H
+#define FRAME_CHROME_H
+
+/* Labels, icons and lines that are the same in every frame, drawn by frame_draw_chrome() in src/frame.c.
+ * Bands start as a copy of their rows, so the widgets only draw what depends on their inputs.
+ *
+ * src/frame_chrome.c is generated on the host by tools/frame_preview and checked in, the frame_chrome test
+ * there fails until it is regenerated after the chrome changes. Only rows with anything in them are stored,
+ * once however many times they appear, and each row of the frame is an index into them */
+#define FRAME_CHROME_BLANK -1
+
+extern const int16_t frame_chrome_index[EPD_HEIGHT]; // FRAME_CHROME_BLANK for rows with nothing in them
+extern const uint8_t frame_chrome_rows[][EPD_BYTE_WIDTH];
+
+#if defined(FRAME_CHROME_GENERATOR)
+/* Draws one band of the chrome into a zeroed buffer, for tools/frame_preview to generate src/frame_chrome.c */
+void frame_render_chrome(uint8_t *buffer, int top);
+#endif
+
+#endif
@@ -0,0 +1,27 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "epd.h"
+
+#ifndef FRAME_DAMAGE_H
+#define FRAME_DAMAGE_H
+
+/* Bounding boxes reported by the drawing primitives, merged into a handful of regions so the display
+ * code can tell which parts of the frame have anything drawn in them without scanning it */
+
+#define FRAME_DAMAGE_MAX_REGIONS 8
+#define FRAME_DAMAGE_MERGE_SLACK 8 // Boxes closer than this are merged, nearby text shouldn't use up regions
+
+typedef struct
+{
+    int count;
+    epd_rect_t regions[FRAME_DAMAGE_MAX_REGIONS];
+} frame_damage_t;
+
+void frame_damage_reset(frame_damage_t *damage);
+void frame_damage_add(frame_damage_t *damage, int x, int y, int width, int height);
+bool frame_damage_intersects(const frame_damage_t *damage, int y, int height);
+uint32_t frame_damage_area(const frame_damage_t *damage);
+/* Box around every region, empty with no regions */
+epd_rect_t frame_damage_bounds(const frame_damage_t *damage);
+
+#endif
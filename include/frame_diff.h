@@ -0,0 +1,39 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "epd.h"
+#include "frame_damage.h"
+
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+/* Hashes of the last frame sent to the display are kept in RTC memory across deep sleep, a block of rows
+ * and columns at a time, so the next frame can be compared against them and only the blocks that changed
+ * sent as partial windows */
+
+#define FRAME_DIFF_MAX_RECTS        4
+#define FRAME_DIFF_FULL_PERCENT     35 // Dirty area past which a full refresh is cheaper than partial windows
+
+typedef struct
+{
+    bool full; // No usable previous frame, or too much changed
+    int count;
+    uint32_t dirty_pixels;
+    epd_rect_t rects[FRAME_DIFF_MAX_RECTS];
+} frame_diff_t;
+
+/* Renders every band, compares its blocks with the previous frame's hashes and prepares the new hashes to
+ * be stored. An empty non-full diff means the frame is identical and the refresh can be skipped.
+ * changed holds the regions that may differ from what the display shows, or is NULL if any of it may.
+ * Bands outside them are taken from the previous frame without rendering them, and without a previous
+ * frame to compare against the regions themselves are what gets sent */
+esp_err_t frame_diff_compute(epd_band_renderer_t render, const frame_damage_t *changed, frame_diff_t *diff);
+/* Marks a region the display no longer shows the stored frame in, because something else has drawn there
+ * since. It's sent by the next frame_diff_compute() whatever its hashes compare as */
+void frame_diff_drawn_over(int x, int y, int width, int height);
+/* Stores the hashes prepared by frame_diff_compute() once the frame is actually on the display */
+void frame_diff_commit(void);
+/* Forgets the previous frame, e.g. after something else has been drawn over it */
+void frame_diff_invalidate(void);
+
+#endif
@@ -0,0 +1,69 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "fonts.h"
+#include "icons.h"
+
+#ifndef FRAME_LIST_H
+#define FRAME_LIST_H
+
+/* Draw operations recorded once per frame along with the rows they cover, so each band only replays the
+ * operations that reach into it rather than running all of the drawing code again. Every operation ORs
+ * pixels in, so the order they are replayed in doesn't change the result */
+
+#if !defined(FRAME_LIST_MAX_OPS) // Set lower by tools/frame_preview to test what happens when the list is full
+#define FRAME_LIST_MAX_OPS      384
+#endif
+#define FRAME_LIST_TEXT_SIZE    1024 // Text runs are copied in, the strings drawn are mostly reused buffers
+
+typedef enum
+{
+    FRAME_OP_TEXT,
+    FRAME_OP_ROTATED_TEXT,
+    FRAME_OP_GLYPH,
+    FRAME_OP_ROTATED_CHAR,
+    FRAME_OP_IMAGE,
+    FRAME_OP_CIRCLE,
+    FRAME_OP_SPAN,
+    FRAME_OP_LINE,
+    FRAME_OP_PATTERN,
+    FRAME_OP_TRIANGLE
+} frame_op_type_t;
+
+/* Arguments are kept as the primitive was called with them, coordinates can be off screen. Fonts are the
+ * globals in fonts.h and only referenced, a copy would make every operation the size of a font_t */
+typedef struct
+{
+    uint8_t type; // frame_op_type_t
+    int16_t top;
+    int16_t bottom; // Exclusive
+    union
+    {
+        struct { int16_t x, y; uint16_t text; const font_t *font; } text; // Offset of the string in the list's text
+        struct { int16_t x, y; uint16_t index; const font_t *font; } glyph; // Character for rotated chars
+        struct { int16_t x, y; icon_t icon; } image;
+        struct { int16_t x, y, radius; } circle;
+        struct { int16_t x0, x1, y; } span;
+        struct { int16_t x0, y0, x1, y1, thickness; } line; // Segments of polylines too
+        struct { int16_t x0, y0, x1, y1, period; const uint8_t *pattern; } pattern;
+        struct { int16_t x0, y0, x1, y1, x2, y2; } triangle;
+    };
+} frame_op_t;
+
+typedef struct
+{
+    int count;
+    bool overflow; // Something didn't fit, so the list can't stand in for the drawing code
+    uint16_t text_size;
+    frame_op_t ops[FRAME_LIST_MAX_OPS];
+    char text[FRAME_LIST_TEXT_SIZE];
+} frame_list_t;
+
+void frame_list_reset(frame_list_t *list);
+/* Appends a copy of the operation, which covers rows [y, y + height) */
+void frame_list_add(frame_list_t *list, const frame_op_t *op, int y, int height);
+/* Copies the string in and returns its offset for a text operation */
+uint16_t frame_list_add_text(frame_list_t *list, const char *str);
+/* Whether the operation covers any of rows [y, y + height) */
+bool frame_list_reaches(const frame_op_t *op, int y, int height);
+
+#endif
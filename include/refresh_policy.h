@@ -0,0 +1,161 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "display.h"
+
+#ifndef REFRESH_POLICY_H
+#define REFRESH_POLICY_H
+
+/* Picks how the panel should be refreshed, shared by the main CPU and the ULP as both update the same
+ * panel. Partial refreshes leave a little ghosting behind each time, so every screen cell counts the
+ * partial refreshes it has had since the last refresh that cleared it, and a cheaper mode is only chosen
+ * while every cell it touches is inside the ghosting budget.
+ *
+ * The state lives in ULP memory (refresh_policy in clock.c) so both sides see the same counts, which is
+ * why everything here is a 32-bit or 8-bit field and the functions are header only like epd_bitbang.h */
+
+typedef enum
+{
+    REFRESH_PARTIAL = 0, // Only the window is driven, accumulates ghosting
+    REFRESH_FAST,        // Whole panel with the fast waveform, clears partial ghosting but not all of it
+    REFRESH_FULL,        // Whole panel with the default waveform, clears everything
+    REFRESH_MODES
+} refresh_mode_t;
+
+#define REFRESH_POLICY_CELL_WIDTH   100
+#define REFRESH_POLICY_CELL_HEIGHT  120
+#define REFRESH_POLICY_COLUMNS      (EPD_WIDTH / REFRESH_POLICY_CELL_WIDTH)
+#define REFRESH_POLICY_ROWS         (EPD_HEIGHT / REFRESH_POLICY_CELL_HEIGHT)
+
+typedef struct
+{
+    uint32_t max_partial;     // Partial refreshes a cell can take before it has to be cleared
+    uint32_t max_fast;        // Fast refreshes between full ones
+    uint32_t full_minutes;    // Full refresh at least this often regardless of the counts
+    uint32_t fast_percent;    // Screen area past which a partial window costs more than a fast refresh
+} refresh_policy_config_t;
+
+/* Roughly the old behaviour of one full refresh every 5 ULP updates, stretched out now that only the cells
+ * that were actually redrawn count towards it */
+#define REFRESH_POLICY_DEFAULT_CONFIG() \
+    { .max_partial = 10, .max_fast = 6, .full_minutes = 12 * 60, .fast_percent = 35 }
+
+typedef struct
+{
+    refresh_policy_config_t config;
+    uint32_t valid; // 0 until the first full refresh, panel contents are unknown before it
+    uint32_t minutes_since_full;
+    uint32_t fast_since_full;
+    uint32_t counts[REFRESH_MODES]; // Refreshes done in each mode since refresh_policy_reset()
+    uint8_t partial[REFRESH_POLICY_ROWS][REFRESH_POLICY_COLUMNS];
+} refresh_policy_t;
+
+static inline void refresh_policy_reset(refresh_policy_t *policy)
+{
+    const refresh_policy_config_t config = REFRESH_POLICY_DEFAULT_CONFIG();
+    uint8_t *bytes = (uint8_t *)policy; // No memset on the ULP
+    for (uint32_t i = 0; i < sizeof(*policy); i++)
+    {
+        bytes[i] = 0;
+    }
+    policy->config = config;
+}
+
+/* Called once a minute by the ULP, which is the only thing that runs on a steady schedule */
+static inline void refresh_policy_tick(refresh_policy_t *policy)
+{
+    policy->minutes_since_full++;
+}
+
+/* Cells overlapped by the window, clipped to the screen. Returns false for an empty window */
+static inline bool refresh_policy_cells(int x, int y, int width, int height,
+        int *first_column, int *last_column, int *first_row, int *last_row)
+{
+    int right = x + width - 1,
+        bottom = y + height - 1;
+    x = (x < 0) ? 0 : x;
+    y = (y < 0) ? 0 : y;
+    right = (right >= EPD_WIDTH) ? (EPD_WIDTH - 1) : right;
+    bottom = (bottom >= EPD_HEIGHT) ? (EPD_HEIGHT - 1) : bottom;
+    if (right < x || bottom < y)
+    {
+        return false;
+    }
+    *first_column = x / REFRESH_POLICY_CELL_WIDTH;
+    *last_column = right / REFRESH_POLICY_CELL_WIDTH;
+    *first_row = y / REFRESH_POLICY_CELL_HEIGHT;
+    *last_row = bottom / REFRESH_POLICY_CELL_HEIGHT;
+    return true;
+}
+
+/* Cheapest mode that can update the window without going over the ghosting budget */
+static inline refresh_mode_t refresh_policy_choose(const refresh_policy_t *policy, int x, int y, int width, int height)
+{
+    const refresh_policy_config_t *config = &policy->config;
+    int first_column, last_column, first_row, last_row;
+
+    if (!policy->valid || policy->minutes_since_full >= config->full_minutes)
+    {
+        return REFRESH_FULL;
+    }
+    /* Whole screen updates can't be partial, so they come down to whether a fast one is still allowed */
+    refresh_mode_t cleared = (policy->fast_since_full < config->max_fast) ? REFRESH_FAST : REFRESH_FULL;
+    if ((uint32_t)width * height >= ((EPD_WIDTH * EPD_HEIGHT) / 100) * config->fast_percent)
+    {
+        return cleared;
+    }
+    if (!refresh_policy_cells(x, y, width, height, &first_column, &last_column, &first_row, &last_row))
+    {
+        return REFRESH_PARTIAL;
+    }
+    for (int row = first_row; row <= last_row; row++)
+    {
+        for (int column = first_column; column <= last_column; column++)
+        {
+            if (policy->partial[row][column] >= config->max_partial)
+            {
+                return cleared;
+            }
+        }
+    }
+    return REFRESH_PARTIAL;
+}
+
+/* Records a refresh once it has been sent, the window is ignored for whole screen modes */
+static inline void refresh_policy_record(refresh_policy_t *policy, refresh_mode_t mode,
+        int x, int y, int width, int height)
+{
+    int first_column, last_column, first_row, last_row;
+
+    policy->counts[mode]++;
+    if (mode == REFRESH_PARTIAL)
+    {
+        if (refresh_policy_cells(x, y, width, height, &first_column, &last_column, &first_row, &last_row))
+        {
+            for (int row = first_row; row <= last_row; row++)
+            {
+                for (int column = first_column; column <= last_column; column++)
+                {
+                    policy->partial[row][column] += (policy->partial[row][column] < UINT8_MAX);
+                }
+            }
+        }
+        return;
+    }
+    for (int row = 0; row < REFRESH_POLICY_ROWS; row++)
+    {
+        for (int column = 0; column < REFRESH_POLICY_COLUMNS; column++)
+        {
+            policy->partial[row][column] = 0;
+        }
+    }
+    if (mode == REFRESH_FAST)
+    {
+        policy->fast_since_full++;
+    } else {
+        policy->valid = 1;
+        policy->fast_since_full = 0;
+        policy->minutes_since_full = 0;
+    }
+}
+
+#endif
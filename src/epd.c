@@ -0,0 +1,205 @@
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "display.h"
+#include "epd.h"
+
+static const epd_bus_t *bus = NULL;
+static DMA_ATTR uint8_t bands[2][EPD_BAND_SIZE];
+
+static void spi_write_command(uint8_t command)
+{
+    bus->write_command(command);
+}
+
+static void spi_write_data(uint8_t data)
+{
+    bus->write_data(&data, 1);
+}
+
+esp_err_t epd_init(const epd_bus_t *epd_bus, bool fast_refresh)
+{
+    esp_err_t err = epd_bus->init();
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    bus = epd_bus;
+
+    /* Datasheet at https://files.waveshare.com/upload/6/60/7.5inch_e-Paper_V2_Specification.pdf
+     * was used as a reference for the initialization sequence and commands */
+    bus->reset();
+
+    /* Default from datasheet unless otherwise specified */
+    spi_write_command(BOOSTER_SOFT_START);
+    spi_write_data(0x17);
+    spi_write_data(0x17);
+    spi_write_data(0x27);
+    spi_write_data(0x17);
+
+    spi_write_command(POWER_SETTING);
+    spi_write_data(0x07);
+    spi_write_data(0x17);
+    spi_write_data(0x3f);
+    spi_write_data(0x3f);
+
+    spi_write_command(POWER_ON);
+    bus->wait_until_idle();
+
+    spi_write_command(PANEL_SETTING);
+    spi_write_data(0x1f);
+
+    spi_write_command(RESOLUTION_SETTING);
+    spi_write_data(0x03);
+    spi_write_data(0x20);
+    spi_write_data(0x01);
+    spi_write_data(0xe0);
+
+    spi_write_command(DUAL_SPI);
+    spi_write_data(0x00);
+
+    spi_write_command(TCON_SETTING);
+    spi_write_data(0x22);
+
+    /* Altered from default to transfer data from NEW to OLD automatically */
+    spi_write_command(VCOM_DATA_INTERVAL);
+    spi_write_data(0x18);
+    spi_write_data(0x07);
+
+    if (fast_refresh)
+    {
+        spi_write_command(CASCADE_SETTING);
+        spi_write_data(0x02);
+        spi_write_command(FORCE_TEMPERATURE);
+        spi_write_data(0x5a);
+    }
+
+    ESP_LOGI("epd", "Initialization complete over %s bus, %s refresh", bus->name, fast_refresh ? "fast" : "full");
+    return ESP_OK;
+}
+
+void epd_clear(void)
+{
+    static DMA_ATTR uint8_t blank_row[EPD_BYTE_WIDTH] = {0};
+    bus->wait_until_idle();
+    spi_write_command(TRANSFER_DATA_2);
+    for (size_t i = 0; i < EPD_HEIGHT; i++)
+    {
+        bus->write_data(blank_row, sizeof(blank_row));
+    }
+    spi_write_command(DISPLAY_REFRESH);
+    bus->wait_until_idle();
+}
+
+void epd_write_frame(const uint8_t *frame, size_t size)
+{
+    bus->wait_until_idle();
+    spi_write_command(TRANSFER_DATA_2);
+    /* Frame is contiguous so the bus can send it in as few transactions as it supports */
+    bus->write_data(frame, size);
+    spi_write_command(DISPLAY_REFRESH);
+    bus->wait_until_idle();
+}
+
+void epd_write_banded(epd_band_renderer_t render)
+{
+    int current = 0;
+
+    memset(bands[current], 0x00, EPD_BAND_SIZE);
+    render(bands[current], 0);
+
+    bus->wait_until_idle();
+    spi_write_command(TRANSFER_DATA_2);
+    for (int top = 0; top < EPD_HEIGHT; top += EPD_BAND_HEIGHT)
+    {
+        bus->queue_data(bands[current], EPD_BAND_SIZE);
+        /* Render the next band into the other buffer while this one streams out */
+        if ((top + EPD_BAND_HEIGHT) < EPD_HEIGHT)
+        {
+            memset(bands[!current], 0x00, EPD_BAND_SIZE);
+            render(bands[!current], top + EPD_BAND_HEIGHT);
+        }
+        bus->flush();
+        current = !current;
+    }
+    spi_write_command(DISPLAY_REFRESH);
+    bus->wait_until_idle();
+}
+
+static void epd_set_partial_window(const epd_rect_t *rect)
+{
+    uint16_t right = rect->x + rect->width - 1,
+             bottom = rect->y + rect->height - 1;
+    spi_write_command(PARTIAL_WINDOW);
+    spi_write_data(rect->x / 256);
+    spi_write_data(rect->x % 256);
+    spi_write_data(right / 256);
+    spi_write_data(right % 256);
+    spi_write_data(rect->y / 256);
+    spi_write_data(rect->y % 256);
+    spi_write_data(bottom / 256);
+    spi_write_data(bottom % 256);
+    spi_write_data(0x00); // Gates only scan inside the window
+}
+
+void epd_write_partial(const epd_rect_t *rects, int count, epd_band_renderer_t render)
+{
+    epd_rect_t bounds = rects[0];
+
+    bus->wait_until_idle();
+    spi_write_command(PARTIAL_IN);
+    for (int i = 0; i < count; i++)
+    {
+        const epd_rect_t *rect = &rects[i];
+        const size_t left_byte = rect->x / BITS_PER_BYTE,
+                     width_bytes = rect->width / BITS_PER_BYTE;
+
+        epd_set_partial_window(rect);
+        spi_write_command(TRANSFER_DATA_2);
+        /* Render every band the window touches, and pack the window's slice of it into the second buffer */
+        for (int top = (rect->y / EPD_BAND_HEIGHT) * EPD_BAND_HEIGHT; top < (rect->y + rect->height);
+                top += EPD_BAND_HEIGHT)
+        {
+            int first = (rect->y > top) ? rect->y : top,
+                last = ((rect->y + rect->height) < (top + EPD_BAND_HEIGHT)) ?
+                    (rect->y + rect->height) : (top + EPD_BAND_HEIGHT);
+            size_t packed = 0;
+
+            memset(bands[0], 0x00, EPD_BAND_SIZE);
+            render(bands[0], top);
+            for (int y = first; y < last; y++)
+            {
+                memcpy(&bands[1][packed], &bands[0][(y - top) * EPD_BYTE_WIDTH + left_byte], width_bytes);
+                packed += width_bytes;
+            }
+            bus->write_data(bands[1], packed);
+        }
+
+        /* Grow the bounding box that gets refreshed at the end */
+        uint16_t right = ((bounds.x + bounds.width) > (rect->x + rect->width)) ?
+                    (bounds.x + bounds.width) : (rect->x + rect->width),
+                 bottom = ((bounds.y + bounds.height) > (rect->y + rect->height)) ?
+                    (bounds.y + bounds.height) : (rect->y + rect->height);
+        bounds.x = (bounds.x < rect->x) ? bounds.x : rect->x;
+        bounds.y = (bounds.y < rect->y) ? bounds.y : rect->y;
+        bounds.width = right - bounds.x;
+        bounds.height = bottom - bounds.y;
+    }
+
+    /* Panel RAM outside the windows still holds the previous frame (the ULP's full refresh relies on the
+     * same), so one refresh over the bounding box is enough and avoids a refresh cycle per window */
+    epd_set_partial_window(&bounds);
+    spi_write_command(DISPLAY_REFRESH);
+    bus->wait_until_idle();
+    spi_write_command(PARTIAL_OUT);
+}
+
+esp_err_t epd_sleep(void)
+{
+    spi_write_command(POWER_OFF);
+    bus->wait_until_idle();
+    epd_bus_log_stats(bus->name);
+    esp_err_t err = bus->release();
+    bus = NULL;
+    return err;
+}
@@ -0,0 +1,376 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "display.h"
+#include "epd_bus.h"
+#include "epd_spi.h"
+
+#if defined(__linux__)
+/* Pin mappings in display.h expand to the driver's gpio_num_t names, which don't exist on the host */
+enum
+{
+    GPIO_NUM_3  = 3,
+    GPIO_NUM_4  = 4,
+    GPIO_NUM_7  = 7,
+    GPIO_NUM_9  = 9,
+    GPIO_NUM_15 = 15,
+    GPIO_NUM_17 = 17,
+    GPIO_NUM_18 = 18
+};
+static void trace_gpio_write(int pin, int level, bool count_stats);
+#define EPD_GPIO_WRITE(pin, level) trace_gpio_write(pin, level, false)
+#else
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/rtc_io.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#define EPD_GPIO_WRITE(pin, level) rtc_gpio_set_level(pin, level)
+#endif
+#include "epd_bitbang.h"
+
+epd_bus_stats_t epd_bus_stats;
+static int last_dc = -1;
+
+static void stats_reset(void)
+{
+    memset(&epd_bus_stats, 0, sizeof(epd_bus_stats));
+    last_dc = -1;
+}
+
+static void stats_record(int dc, size_t bytes, size_t transactions)
+{
+    if (dc != last_dc)
+    {
+        epd_bus_stats.dc_toggles++;
+        last_dc = dc;
+    }
+    if (dc == LOW)
+    {
+        epd_bus_stats.commands += bytes;
+    } else {
+        epd_bus_stats.data_bytes += bytes;
+    }
+    epd_bus_stats.transactions += transactions;
+}
+
+static void stats_record_busy(uint32_t elapsed_ms)
+{
+    if (epd_bus_stats.busy_waits < EPD_BUSY_HISTORY)
+    {
+        epd_bus_stats.busy_ms[epd_bus_stats.busy_waits] = elapsed_ms;
+    }
+    epd_bus_stats.busy_waits++;
+    epd_bus_stats.busy_total_ms += elapsed_ms;
+}
+
+void epd_bus_log_stats(const char *label)
+{
+    ESP_LOGI("epd_bus", "%s: %lu commands, %lu data bytes, %lu transactions, %lu DC toggles",
+            label, (unsigned long)epd_bus_stats.commands, (unsigned long)epd_bus_stats.data_bytes,
+            (unsigned long)epd_bus_stats.transactions, (unsigned long)epd_bus_stats.dc_toggles);
+    ESP_LOGI("epd_bus", "%s: %lu busy waits (%lu timed out) totalling %lums",
+            label, (unsigned long)epd_bus_stats.busy_waits, (unsigned long)epd_bus_stats.busy_timeouts,
+            (unsigned long)epd_bus_stats.busy_total_ms);
+    for (uint32_t i = 0; i < epd_bus_stats.busy_waits && i < EPD_BUSY_HISTORY; i++)
+    {
+        ESP_LOGI("epd_bus", "%s: busy wait %lu took %lums", label, (unsigned long)i,
+                (unsigned long)epd_bus_stats.busy_ms[i]);
+    }
+}
+
+/* Buses without a background transfer just write synchronously */
+static void bus_flush_noop(void)
+{
+}
+
+#if defined(__linux__)
+
+#define TRACE_BYTES_PER_LINE 32
+
+static FILE *trace_file = NULL;
+static const char *trace_path = "epd_trace.txt";
+static int trace_line_bytes = 0; // Bytes on the currently open D line, 0 if none is open
+
+static void trace_end_line(void)
+{
+    if (trace_file != NULL && trace_line_bytes > 0)
+    {
+        fputc('\n', trace_file);
+    }
+    trace_line_bytes = 0;
+}
+
+static void trace_event(char event)
+{
+    if (trace_file == NULL) { return; }
+    trace_end_line();
+    fprintf(trace_file, "%c\n", event);
+}
+
+static void trace_command(uint8_t command)
+{
+    if (trace_file == NULL) { return; }
+    trace_end_line();
+    fprintf(trace_file, "C %02x\n", command);
+}
+
+static void trace_data(uint8_t data)
+{
+    if (trace_file == NULL) { return; }
+    fprintf(trace_file, (trace_line_bytes == 0) ? "D %02x" : " %02x", data);
+    if (++trace_line_bytes == TRACE_BYTES_PER_LINE)
+    {
+        trace_end_line();
+    }
+}
+
+/* Reassembles bytes from pin level changes the same way the panel does, sampling MOSI on SCK rising edges
+ * while CS is low and using DC at the end of the byte to tell commands from data */
+static void trace_gpio_write(int pin, int level, bool count_stats)
+{
+    static int cs = HIGH, dc = -1, sck = LOW, mosi = LOW, bits = 0;
+    static uint8_t shift = 0;
+
+    switch (pin)
+    {
+        case CS_PIN:
+            if (level == LOW && cs == HIGH)
+            {
+                bits = 0;
+                epd_bus_stats.transactions += count_stats;
+            }
+            cs = level;
+            break;
+        case DC_PIN:
+            epd_bus_stats.dc_toggles += (count_stats && level != dc);
+            dc = level;
+            break;
+        case MOSI_PIN:
+            mosi = level;
+            break;
+        case SCK_PIN:
+            if (level == HIGH && sck == LOW && cs == LOW)
+            {
+                shift = (uint8_t)((shift << 1) | (mosi & 1));
+                if (++bits == BITS_PER_BYTE)
+                {
+                    bits = 0;
+                    if (dc == LOW)
+                    {
+                        epd_bus_stats.commands += count_stats;
+                        trace_command(shift);
+                    } else {
+                        epd_bus_stats.data_bytes += count_stats;
+                        trace_data(shift);
+                    }
+                }
+            }
+            sck = level;
+            break;
+        case RST_PIN:
+            if (level == LOW)
+            {
+                trace_event('R');
+            }
+            break;
+    }
+}
+
+void epd_bus_trace_gpio_write(int pin, int level)
+{
+    trace_gpio_write(pin, level, true);
+}
+
+void epd_bus_trace_set_path(const char *path)
+{
+    trace_path = path;
+}
+
+/* The host has no panel, so a reset or busy wait is only recorded */
+static void bus_reset(void)
+{
+    trace_event('R');
+}
+
+static void bus_wait_until_idle(void)
+{
+    stats_record_busy(0);
+    trace_event('W');
+}
+
+static esp_err_t trace_backend_init(void)
+{
+    stats_reset();
+    trace_line_bytes = 0;
+    trace_file = fopen(trace_path, "w");
+    return (trace_file != NULL) ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t trace_backend_release(void)
+{
+    if (trace_file == NULL)
+    {
+        return ESP_OK;
+    }
+    trace_end_line();
+    fprintf(trace_file, "# commands=%lu data_bytes=%lu transactions=%lu dc_toggles=%lu busy_waits=%lu\n",
+            (unsigned long)epd_bus_stats.commands, (unsigned long)epd_bus_stats.data_bytes,
+            (unsigned long)epd_bus_stats.transactions, (unsigned long)epd_bus_stats.dc_toggles,
+            (unsigned long)epd_bus_stats.busy_waits);
+    fclose(trace_file);
+    trace_file = NULL;
+    return ESP_OK;
+}
+
+static void trace_backend_write_command(uint8_t command)
+{
+    stats_record(LOW, 1, 1);
+    trace_command(command);
+}
+
+static void trace_backend_write_data(const uint8_t *data, size_t length)
+{
+    stats_record(HIGH, length, 1);
+    for (size_t i = 0; i < length; i++)
+    {
+        trace_data(data[i]);
+    }
+}
+
+const epd_bus_t epd_bus_trace =
+{
+    .name = "trace",
+    .init = trace_backend_init,
+    .release = trace_backend_release,
+    .write_command = trace_backend_write_command,
+    .write_data = trace_backend_write_data,
+    .queue_data = trace_backend_write_data,
+    .flush = bus_flush_noop,
+    .wait_until_idle = bus_wait_until_idle,
+    .reset = bus_reset
+};
+
+#else
+
+/* RST and BUSY stay on RTC GPIO for every backend, only the SPI lines are ever handed to a peripheral */
+static void bus_reset(void)
+{
+    rtc_gpio_set_level(RST_PIN, HIGH);
+    vTaskDelay(20 / portTICK_PERIOD_MS);
+    rtc_gpio_set_level(RST_PIN, LOW); // Low is active
+    vTaskDelay(20 / portTICK_PERIOD_MS);
+    rtc_gpio_set_level(RST_PIN, HIGH);
+}
+
+/* BUSY is held low while the panel works, which for a refresh is seconds. Rather than polling, the CPU
+ * light sleeps until BUSY goes high or the timeout expires */
+static void bus_wait_until_idle(void)
+{
+    const int64_t start_us = esp_timer_get_time(),
+                  timeout_us = EPD_BUSY_TIMEOUT_MS * 1000LL;
+    int64_t elapsed_us = 0;
+
+    while (rtc_gpio_get_level(BUSY_PIN) == LOW)
+    {
+        if (elapsed_us >= timeout_us)
+        {
+            ESP_LOGE("epd", "Display still busy after %dms", EPD_BUSY_TIMEOUT_MS);
+            epd_bus_stats.busy_timeouts++;
+            break;
+        }
+        esp_sleep_enable_ext0_wakeup(BUSY_PIN, HIGH);
+        esp_sleep_enable_timer_wakeup(timeout_us - elapsed_us);
+        esp_light_sleep_start();
+        elapsed_us = esp_timer_get_time() - start_us;
+    }
+    /* Leave the wakeup sources as they were found, deep sleep sets up its own */
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_EXT0);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    stats_record_busy(elapsed_ms);
+    ESP_LOGI("epd", "Display released after %lums", (unsigned long)elapsed_ms);
+}
+
+#endif
+
+/* Pins are already configured as RTC outputs by the time the display is used */
+static esp_err_t gpio_backend_init(void)
+{
+    stats_reset();
+    return ESP_OK;
+}
+
+static esp_err_t gpio_backend_release(void)
+{
+    return ESP_OK;
+}
+
+static void gpio_backend_write_command(uint8_t command)
+{
+    stats_record(LOW, 1, 1);
+    epd_bitbang_write_command(command);
+}
+
+static void gpio_backend_write_data(const uint8_t *data, size_t length)
+{
+    stats_record(HIGH, length, 1);
+    epd_bitbang_write_burst(data, length);
+}
+
+const epd_bus_t epd_bus_gpio =
+{
+    .name = "gpio",
+    .init = gpio_backend_init,
+    .release = gpio_backend_release,
+    .write_command = gpio_backend_write_command,
+    .write_data = gpio_backend_write_data,
+    .queue_data = gpio_backend_write_data,
+    .flush = bus_flush_noop,
+    .wait_until_idle = bus_wait_until_idle,
+    .reset = bus_reset
+};
+
+static esp_err_t spi_backend_init(void)
+{
+    stats_reset();
+    return epd_spi_init();
+}
+
+static esp_err_t spi_backend_release(void)
+{
+    return epd_spi_release();
+}
+
+static void spi_backend_write_command(uint8_t command)
+{
+    stats_record(LOW, 1, 1);
+    epd_spi_write_command(command);
+}
+
+static void spi_backend_write_data(const uint8_t *data, size_t length)
+{
+    stats_record(HIGH, length, (length + EPD_SPI_MAX_TRANSFER - 1) / EPD_SPI_MAX_TRANSFER);
+    epd_spi_write_data(data, length);
+}
+
+static void spi_backend_queue_data(const uint8_t *data, size_t length)
+{
+    stats_record(HIGH, length, (length + EPD_SPI_MAX_TRANSFER - 1) / EPD_SPI_MAX_TRANSFER);
+    epd_spi_queue_data(data, length);
+}
+
+const epd_bus_t epd_bus_spi =
+{
+    .name = "spi",
+    .init = spi_backend_init,
+    .release = spi_backend_release,
+    .write_command = spi_backend_write_command,
+    .write_data = spi_backend_write_data,
+    .queue_data = spi_backend_queue_data,
+    .flush = epd_spi_flush,
+    .wait_until_idle = bus_wait_until_idle,
+    .reset = bus_reset
+};
@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <string.h>
+#include "epd_spi.h"
+
+#if defined(__linux__)
+
+/* Host mock, every command and data byte is appended to a growable stream so the exact
+ * sequence the display would receive can be compared off-device */
+static uint16_t *mock_stream = NULL;
+static size_t mock_length = 0;
+static size_t mock_capacity = 0;
+static size_t mock_transactions = 0;
+
+static void mock_record(uint16_t entry)
+{
+    if (mock_length == mock_capacity)
+    {
+        mock_capacity = (mock_capacity == 0) ? 1024 : (mock_capacity * 2);
+        mock_stream = realloc(mock_stream, mock_capacity * sizeof(mock_stream[0]));
+        if (mock_stream == NULL)
+        {
+            abort();
+        }
+    }
+    mock_stream[mock_length++] = entry;
+}
+
+esp_err_t epd_spi_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t epd_spi_release(void)
+{
+    return ESP_OK;
+}
+
+void epd_spi_write_command(uint8_t command)
+{
+    mock_record(EPD_SPI_MOCK_COMMAND | command);
+    mock_transactions++;
+}
+
+void epd_spi_write_data(const uint8_t *data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t chunk = (length > EPD_SPI_MAX_TRANSFER) ? EPD_SPI_MAX_TRANSFER : length;
+        for (size_t i = 0; i < chunk; i++)
+        {
+            mock_record(data[i]);
+        }
+        data += chunk;
+        length -= chunk;
+        mock_transactions++;
+    }
+}
+
+/* Nothing runs in the background on the host, so queueing is just writing */
+void epd_spi_queue_data(const uint8_t *data, size_t length)
+{
+    epd_spi_write_data(data, length);
+}
+
+void epd_spi_flush(void)
+{
+}
+
+const uint16_t *epd_spi_mock_stream(size_t *length)
+{
+    *length = mock_length;
+    return mock_stream;
+}
+
+size_t epd_spi_mock_transactions(void)
+{
+    return mock_transactions;
+}
+
+void epd_spi_mock_reset(void)
+{
+    free(mock_stream);
+    mock_stream = NULL;
+    mock_length = 0;
+    mock_capacity = 0;
+    mock_transactions = 0;
+}
+
+#else
+
+#include "driver/gpio.h"
+#include "driver/rtc_io.h"
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+#define EPD_SPI_HOST SPI2_HOST
+
+static spi_device_handle_t spi_handle = NULL;
+/* Ring of transactions handed to the driver by epd_spi_queue_data(), they must stay valid until completed */
+static spi_transaction_t queued[EPD_SPI_QUEUE_DEPTH];
+static size_t queued_head = 0;
+static size_t queued_count = 0;
+static const gpio_num_t spi_pins[] = {MOSI_PIN, SCK_PIN, CS_PIN, DC_PIN};
+
+/* DC is not part of the SPI peripheral, so it is set from the transaction's user field right before
+ * CS goes low. Runs from the SPI ISR for queued transactions, hence IRAM */
+static void IRAM_ATTR spi_pre_transfer_callback(spi_transaction_t *transaction)
+{
+    gpio_set_level(DC_PIN, (int)(intptr_t)transaction->user);
+}
+
+esp_err_t epd_spi_init(void)
+{
+    if (spi_handle != NULL)
+    {
+        return ESP_OK;
+    }
+
+    /* Release the pins from RTC GPIO so the GPIO matrix can route them to GPSPI2 */
+    for (int i = 0; i < sizeof(spi_pins) / sizeof(spi_pins[0]); i++)
+    {
+        rtc_gpio_deinit(spi_pins[i]);
+    }
+    gpio_set_direction(DC_PIN, GPIO_MODE_OUTPUT);
+
+    const spi_bus_config_t bus_config =
+    {
+        .mosi_io_num = MOSI_PIN,
+        .miso_io_num = -1,
+        .sclk_io_num = SCK_PIN,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = EPD_SPI_MAX_TRANSFER
+    };
+    esp_err_t err = spi_bus_initialize(EPD_SPI_HOST, &bus_config, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    const spi_device_interface_config_t device_config =
+    {
+        .mode = 0,
+        .clock_speed_hz = EPD_SPI_CLOCK_HZ,
+        .spics_io_num = CS_PIN,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+        .queue_size = EPD_SPI_QUEUE_DEPTH,
+        .pre_cb = spi_pre_transfer_callback
+    };
+    err = spi_bus_add_device(EPD_SPI_HOST, &device_config, &spi_handle);
+    if (err != ESP_OK)
+    {
+        spi_bus_free(EPD_SPI_HOST);
+        return err;
+    }
+    ESP_LOGI("epd_spi", "GPSPI2 initialized at %d Hz", EPD_SPI_CLOCK_HZ);
+    return ESP_OK;
+}
+
+esp_err_t epd_spi_release(void)
+{
+    if (spi_handle == NULL)
+    {
+        return ESP_OK;
+    }
+
+    epd_spi_flush();
+    esp_err_t err = spi_bus_remove_device(spi_handle);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    spi_handle = NULL;
+    err = spi_bus_free(EPD_SPI_HOST);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    /* Hand the pins back to RTC GPIO so they can be held and driven by the ULP during deep sleep */
+    for (int i = 0; i < sizeof(spi_pins) / sizeof(spi_pins[0]); i++)
+    {
+        gpio_reset_pin(spi_pins[i]);
+        rtc_gpio_init(spi_pins[i]);
+        rtc_gpio_set_direction(spi_pins[i], RTC_GPIO_MODE_OUTPUT_ONLY);
+        rtc_gpio_pulldown_dis(spi_pins[i]);
+        rtc_gpio_pullup_dis(spi_pins[i]);
+    }
+    ESP_LOGI("epd_spi", "GPSPI2 released, pins returned to RTC GPIO");
+    return ESP_OK;
+}
+
+static void queued_wait_oldest(void)
+{
+    spi_transaction_t *done;
+    ESP_ERROR_CHECK(spi_device_get_trans_result(spi_handle, &done, portMAX_DELAY));
+    queued_count--;
+}
+
+void epd_spi_flush(void)
+{
+    while (queued_count > 0)
+    {
+        queued_wait_oldest();
+    }
+}
+
+void epd_spi_queue_data(const uint8_t *data, size_t length)
+{
+    while (length > 0)
+    {
+        if (queued_count == EPD_SPI_QUEUE_DEPTH)
+        {
+            queued_wait_oldest(); // Transactions complete in order, so the slot at the head is now free
+        }
+        size_t chunk = (length > EPD_SPI_MAX_TRANSFER) ? EPD_SPI_MAX_TRANSFER : length;
+        spi_transaction_t *transaction = &queued[queued_head];
+        *transaction = (spi_transaction_t)
+        {
+            .length = chunk * BITS_PER_BYTE,
+            .user = (void *)HIGH, // Data mode
+            .tx_buffer = data
+        };
+        ESP_ERROR_CHECK(spi_device_queue_trans(spi_handle, transaction, portMAX_DELAY));
+        queued_head = (queued_head + 1) % EPD_SPI_QUEUE_DEPTH;
+        queued_count++;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+void epd_spi_write_command(uint8_t command)
+{
+    epd_spi_flush(); // Polling transactions can't be mixed with queued ones still in flight
+    spi_transaction_t transaction =
+    {
+        .flags = SPI_TRANS_USE_TXDATA,
+        .length = BITS_PER_BYTE,
+        .user = (void *)LOW, // Command mode
+        .tx_data = {command}
+    };
+    ESP_ERROR_CHECK(spi_device_polling_transmit(spi_handle, &transaction));
+}
+
+void epd_spi_write_data(const uint8_t *data, size_t length)
+{
+    epd_spi_flush();
+    /* Single bytes are cheaper to poll than to set up a DMA descriptor for */
+    if (length <= sizeof(((spi_transaction_t *)0)->tx_data))
+    {
+        spi_transaction_t transaction =
+        {
+            .flags = SPI_TRANS_USE_TXDATA,
+            .length = length * BITS_PER_BYTE,
+            .user = (void *)HIGH // Data mode
+        };
+        memcpy(transaction.tx_data, data, length);
+        ESP_ERROR_CHECK(spi_device_polling_transmit(spi_handle, &transaction));
+        return;
+    }
+
+    while (length > 0)
+    {
+        size_t chunk = (length > EPD_SPI_MAX_TRANSFER) ? EPD_SPI_MAX_TRANSFER : length;
+        spi_transaction_t transaction =
+        {
+            .length = chunk * BITS_PER_BYTE,
+            .user = (void *)HIGH,
+            .tx_buffer = data
+        };
+        ESP_ERROR_CHECK(spi_device_transmit(spi_handle, &transaction));
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "fixed_math.h"
+
+/* sin() of 0-90 degrees in Q15, the other quadrants are mirrored from it */
+static const uint16_t sin_table[91] =
+{
+    0, 572, 1144, 1715, 2286, 2856, 3425, 3993, 4560, 5126,
+    5690, 6252, 6813, 7371, 7927, 8481, 9032, 9580, 10126, 10668,
+    11207, 11743, 12275, 12803, 13328, 13848, 14365, 14876, 15384, 15886,
+    16384, 16877, 17364, 17847, 18324, 18795, 19261, 19720, 20174, 20622,
+    21063, 21498, 21926, 22348, 22763, 23170, 23571, 23965, 24351, 24730,
+    25102, 25466, 25822, 26170, 26510, 26842, 27166, 27482, 27789, 28088,
+    28378, 28660, 28932, 29197, 29452, 29698, 29935, 30163, 30382, 30592,
+    30792, 30983, 31164, 31336, 31499, 31651, 31795, 31928, 32052, 32166,
+    32270, 32365, 32449, 32524, 32588, 32643, 32688, 32723, 32748, 32763,
+    32768,
+};
+
+/* Discharge curve the battery percentage used to be computed from at runtime:
+ *     123 - (123 / pow(1 + pow(volts / 3.7, 80), 0.165))
+ * in tenths of a percent, every BATTERY_STEP_MV from BATTERY_MIN_MV. It's flat outside of this range */
+#define BATTERY_MIN_MV  3400
+#define BATTERY_STEP_MV 20
+#define BATTERY_ENTRIES (sizeof(battery_table) / sizeof(battery_table[0]))
+static const uint16_t battery_table[] =
+{
+    0, 0, 1, 1, 1, 2, 4, 6, 9, 14,
+    21, 32, 48, 69, 97, 133, 175, 223, 275, 328,
+    381, 433, 483, 530, 575, 618, 657, 694, 728, 761,
+    791, 819, 845, 869, 892, 913, 932, 951, 968, 984,
+    999, 1013, 1026, 1039, 1050, 1061,
+};
+
+int32_t fixed_sin(int degrees)
+{
+    degrees %= 360;
+    degrees += (degrees < 0) ? 360 : 0;
+    if (degrees <= 90)
+    {
+        return sin_table[degrees];
+    } else if (degrees <= 180) {
+        return sin_table[180 - degrees];
+    } else if (degrees <= 270) {
+        return -(int32_t)sin_table[degrees - 180];
+    } else {
+        return -(int32_t)sin_table[360 - degrees];
+    }
+}
+
+int32_t fixed_cos(int degrees)
+{
+    return fixed_sin(degrees + 90);
+}
+
+int32_t fixed_div_round(int32_t numerator, int32_t denominator)
+{
+    if (denominator < 0)
+    {
+        numerator = -numerator;
+        denominator = -denominator;
+    }
+    return (numerator >= 0) ? ((numerator + (denominator / 2)) / denominator)
+        : -((-numerator + (denominator / 2)) / denominator);
+}
+
+int32_t fixed_map(int32_t value, int32_t in_min, int32_t in_max, int32_t out_span)
+{
+    return fixed_div_round((value - in_min) * out_span, in_max - in_min);
+}
+
+void fixed_arrow(int x, int y, int degrees, int length, int points[3][2])
+{
+    /* Screen space unit vector in the direction of the wind in Q15, adjusted so 0 degrees is pointing up */
+    const int32_t dx = fixed_sin(degrees),
+                  dy = -fixed_cos(degrees);
+    /* The head is attached halfway along the line and spreads 0.3 of the length either side along the
+     * perpendicular vector (dy, -dx), kept in tenths so both fractions are exact. The screen coordinate is
+     * rounded rather than the offset from (x, y), so halves round up as round() did on the old double one */
+    const int32_t base_x = (10 * FIXED_Q15_ONE * x) + (5 * length * dx),
+                  base_y = (10 * FIXED_Q15_ONE * y) + (5 * length * dy),
+                  spread_x = 3 * length * dy,
+                  spread_y = 3 * length * -dx;
+
+    points[0][0] = x + ((length * dx) >> FIXED_Q15_SHIFT);
+    points[0][1] = y + ((length * dy) >> FIXED_Q15_SHIFT);
+    points[1][0] = fixed_div_round(base_x + spread_x, 10 * FIXED_Q15_ONE);
+    points[1][1] = fixed_div_round(base_y + spread_y, 10 * FIXED_Q15_ONE);
+    points[2][0] = fixed_div_round(base_x - spread_x, 10 * FIXED_Q15_ONE);
+    points[2][1] = fixed_div_round(base_y - spread_y, 10 * FIXED_Q15_ONE);
+}
+
+uint8_t fixed_battery_percentage(uint32_t millivolts)
+{
+    uint32_t tenths;
+    if (millivolts <= BATTERY_MIN_MV)
+    {
+        tenths = battery_table[0];
+    } else if (millivolts >= BATTERY_MIN_MV + (BATTERY_ENTRIES - 1) * BATTERY_STEP_MV) {
+        tenths = battery_table[BATTERY_ENTRIES - 1];
+    } else {
+        /* Linear between the two nearest entries */
+        uint32_t index = (millivolts - BATTERY_MIN_MV) / BATTERY_STEP_MV,
+                 offset = (millivolts - BATTERY_MIN_MV) % BATTERY_STEP_MV;
+        tenths = battery_table[index]
+            + (((battery_table[index + 1] - battery_table[index]) * offset) + (BATTERY_STEP_MV / 2)) / BATTERY_STEP_MV;
+    }
+    tenths = (tenths + 5) / 10;
+    return (tenths > 100) ? 100 : tenths;
+}
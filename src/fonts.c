@@ -1,6 +1,9 @@
 #include "fonts.h"
 
-/* Generated with waveshares Zimo221 tool */
+/* Generated with waveshares Zimo221 tool
+ *
+ * Not compiled into the firmware, these are the source tables tools/font_pack.py and tools/font_rotate.py
+ * generate the fonts from at build time (see src/CMakeLists.txt) */
 
 /* Font data for Courier New 16pt */
 const uint8_t font16_table[] =
@@ -1716,12 +1719,6 @@ const uint8_t font16_table[] =
 	0x00, 0x00, //            
 };
 
-font_t font16 =
-{
-    .width = 11,
-    .height = 16,
-    .table = font16_table
-};
 
 // Character bitmaps for Courier New 15pt
 const uint8_t Font20_Table[] = 
@@ -3818,12 +3815,6 @@ const uint8_t Font20_Table[] =
 };
 
 
-font_t font20 =
-{
-    14, /* Width */
-    20, /* Height */
-    Font20_Table,
-};
 
 const uint8_t Font24_Table [] = 
 {
@@ -6298,12 +6289,6 @@ const uint8_t Font24_Table [] =
 	0x00, 0x00, 0x00, //                  
 };
 
-font_t font24 =
-{
-    17, /* Width */
-    24, /* Height */
-    Font24_Table
-};
 
 const uint8_t Font40_Table [] = 
 {
@@ -10298,11 +10283,6 @@ const uint8_t Font40_Table [] =
 	0x00, 0x00, 0x00,
 };
 
-font_t font40 = {
-	24, // Width
-    40, // Height
-	Font40_Table
-};
 
 const uint8_t font60_table[] =
 {
@@ -10770,12 +10750,6 @@ const uint8_t font60_table[] =
     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
 };
 
-font_t font60 =
-{
-    48,
-    85,
-    font60_table
-};
 
 const uint8_t font12_table[] =
 {
@@ -12110,9 +12084,3 @@ const uint8_t font12_table[] =
 	0x00, //        
 };
 
-font_t font12 =
-{
-  7, /* Width */
-  12, /* Height */
-  font12_table
-};
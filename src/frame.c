@@ -0,0 +1,1349 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_compiler.h"
+#include "esp_log.h"
+#if defined(FRAME_BENCHMARK)
+#include "esp_cpu.h"
+#endif
+#include "display.h"
+#include "epd.h"
+#include "fixed_math.h"
+#include "fonts.h"
+#include "icons.h"
+#include "frame_chrome.h"
+#include "frame_damage.h"
+#include "frame_list.h"
+#include "frame.h"
+
+/* Following functions are placed in IRAM as they are frequently called:
+ * - frame_draw_byte: called by the line and shape drawing functions
+ * - frame_blit: called for every glyph and image */
+
+/* Frame is never held in full, drawing functions write into whichever band epd_write_banded() is filling
+ * and anything outside of it is clipped. The drawing code runs once with no band set to record what it
+ * draws, and each band then replays only the recorded operations that reach into it. Each task has its
+ * own band so the next one can be rasterized on the other core, see frame_render_parallel() in main.c */
+static __thread uint8_t (*band)[EPD_BYTE_WIDTH] = NULL;
+static __thread int band_top = 0;
+#define BAND_MISSES(y, height) (((y) + (height)) <= band_top || (y) >= (band_top + EPD_BAND_HEIGHT))
+
+/* Operations and the regions drawn into, collected by a recording pass that runs the drawing code with no
+ * band set. Each primitive records itself with its bounding box and returns before rasterizing anything,
+ * see frame_record_default(). Primitives called while replaying rasterize straight away */
+static frame_damage_t damage;
+static frame_damage_t widget_damage; // Just the widget being recorded, see frame_record_default()
+static frame_list_t frame_list;
+#define FRAME_RECORD(x, y, width, height, ...) \
+    do { if (band == NULL) { frame_record((x), (y), (width), (height), &(frame_op_t){ __VA_ARGS__ }); return; } } while (0)
+
+static void frame_record(int x, int y, int width, int height, const frame_op_t *op)
+{
+    frame_damage_add(&damage, x, y, width, height);
+    frame_damage_add(&widget_damage, x, y, width, height);
+    frame_list_add(&frame_list, op, y, height);
+}
+
+static void IRAM_ATTR frame_draw_byte(int x, int y, uint8_t byte)
+{
+    if (unlikely(x < 0 || x >= EPD_WIDTH || y < 0 || y >= EPD_HEIGHT))
+    {
+        if (band_top == 0) // Drawing is replayed for every band, only report it once
+        {
+            ESP_LOGE("frame", "Byte position out of bounds: x=%d, y=%d", x, y);
+        }
+        return;
+    }
+    if (BAND_MISSES(y, 1))
+    {
+        return;
+    }
+    y -= band_top;
+    /* Shift the byte to align with the correct bits in the frame buffer, then OR it with the existing byte
+     * to preserve any pixels that have already been drawn in that byte. */
+    band[y][x / BITS_PER_BYTE] |= byte >> (x % BITS_PER_BYTE);
+    /* If the byte being drawn isn't aligned to a byte boundary, then
+     * the byte next to it also needs to be updated with the remaining bits. */
+    if ((x % BITS_PER_BYTE) != 0 && (x / BITS_PER_BYTE + 1) < EPD_BYTE_WIDTH)
+    {
+        band[y][x / BITS_PER_BYTE + 1] |= byte << (BITS_PER_BYTE - (x % BITS_PER_BYTE));
+    }
+}
+
+#if defined(FRAME_BENCHMARK)
+static bool benchmark_bytewise = false; // Blits go through frame_draw_byte() one byte at a time, as they used to
+#endif
+
+/* ORs a 1bpp bitmap into the band 32 bits at a time. Rows are clipped to the band once up front, and each
+ * source word is shifted into the two frame words it straddles rather than placing it a byte at a time.
+ * Frame bytes are MSB first, so words are byte swapped into that order on the way in and out. */
+#define BLIT_WORD_BITS   32
+#define BLIT_WORD_BYTES  (BLIT_WORD_BITS / BITS_PER_BYTE)
+#define BLIT_FRAME_WORDS (EPD_BYTE_WIDTH / BLIT_WORD_BYTES)
+
+static void IRAM_ATTR frame_blit(int x, int y, const uint8_t *src, int src_bytes_per_row, int height)
+{
+#if defined(FRAME_BENCHMARK)
+    if (benchmark_bytewise)
+    {
+        for (int i = 0; i < height; i++)
+        {
+            for (int j = 0; j < src_bytes_per_row; j++)
+            {
+                frame_draw_byte(x + (j * BITS_PER_BYTE), y + i, src[i * src_bytes_per_row + j]);
+            }
+        }
+        return;
+    }
+#endif
+    const int first_row = ((y > band_top) ? y : band_top),
+              last_row = (((y + height) < (band_top + EPD_BAND_HEIGHT)) ? (y + height) : (band_top + EPD_BAND_HEIGHT)),
+              src_words = (src_bytes_per_row + BLIT_WORD_BYTES - 1) / BLIT_WORD_BYTES,
+              shift = x & (BLIT_WORD_BITS - 1),
+              frame_word = (x - shift) / BLIT_WORD_BITS, // Rounds down, x can be negative
+    /* Source words whose bits land anywhere in [0, BLIT_FRAME_WORDS) */
+              first_word = (frame_word < -1) ? (-1 - frame_word) : 0,
+              last_word = ((frame_word + src_words) > BLIT_FRAME_WORDS) ? (BLIT_FRAME_WORDS - frame_word) : src_words;
+
+    for (int row = first_row; row < last_row; row++)
+    {
+        const uint8_t *src_row = &src[(row - y) * src_bytes_per_row];
+        uint32_t *frame_row = (uint32_t *)band[row - band_top]; // Band rows are 100 bytes, so stay word aligned
+
+        for (int word = first_word; word < last_word; word++)
+        {
+            /* Gather up to 4 source bytes MSB first, the tail of the row is padded with zeroes */
+            uint32_t bits = 0;
+            for (int byte = 0; byte < BLIT_WORD_BYTES; byte++)
+            {
+                int index = (word * BLIT_WORD_BYTES) + byte;
+                bits = (bits << BITS_PER_BYTE) | ((index < src_bytes_per_row) ? src_row[index] : 0);
+            }
+            int dst = frame_word + word;
+            if (dst >= 0)
+            {
+                frame_row[dst] |= __builtin_bswap32(bits >> shift);
+            }
+            if (shift != 0 && (dst + 1) < BLIT_FRAME_WORDS)
+            {
+                frame_row[dst + 1] |= __builtin_bswap32(bits << (BLIT_WORD_BITS - shift));
+            }
+        }
+    }
+}
+
+/* Glyphs only store the rows between their first and last non-blank one, see tools/font_pack.py */
+static void frame_draw_glyph(int x, int y, const font_t *font, int index)
+{
+    const uint8_t bytes_per_char = (font->width / BITS_PER_BYTE) + (font->width % BITS_PER_BYTE != 0);
+    const font_glyph_t *glyph = &font->glyphs[index];
+    FRAME_RECORD(x, y + glyph->first_row, bytes_per_char * BITS_PER_BYTE, glyph->rows,
+            .type = FRAME_OP_GLYPH, .glyph = { x, y, index, font });
+    y += glyph->first_row;
+    if (BAND_MISSES(y, glyph->rows))
+    {
+        return;
+    }
+    frame_blit(x, y, font->table + glyph->offset, bytes_per_char, glyph->rows);
+}
+
+static void frame_draw_char(int x, int y, const font_t *font, char c)
+{
+    /* Subtract the first character in the font from the character to get the index */
+    frame_draw_glyph(x, y, font, c - ' ');
+}
+
+static void frame_draw_rotated_char(int x, int y, const font_t *font, char c)
+{
+    const uint8_t bytes_per_row_rot = (font->height / BITS_PER_BYTE) + (font->height % BITS_PER_BYTE != 0);
+    FRAME_RECORD(x, y, bytes_per_row_rot * BITS_PER_BYTE, font->width,
+            .type = FRAME_OP_ROTATED_CHAR, .glyph = { x, y, c, font });
+    if (BAND_MISSES(y, font->width))
+    {
+        return;
+    }
+    if (font->rotated_table != NULL)
+    {
+        frame_blit(x, y, font->rotated_table + ((c - ' ') * font->width * bytes_per_row_rot), bytes_per_row_rot,
+                font->width);
+        return;
+    }
+    /* Fonts without a generated rotated table are turned a bit at a time */
+    const uint8_t bytes_per_char = (font->width / BITS_PER_BYTE) + (font->width % BITS_PER_BYTE != 0);
+    const font_glyph_t *glyph = &font->glyphs[c - ' '];
+    const uint8_t *char_start = font->table + glyph->offset;
+
+    for (int i = 0; i < font->width; i++)
+    {
+        for (int j = 0; j < bytes_per_row_rot; j++)
+        {
+            uint8_t rotated_byte = 0;
+            for (int k = 0; k < BITS_PER_BYTE; k++)
+            {
+                int new_col = (j * BITS_PER_BYTE) + k,
+                    old_row = (font->height - 1) - new_col - glyph->first_row,
+                    old_col = i;
+                if (new_col >= font->height) { break; }
+                if (old_row < 0 || old_row >= glyph->rows) { continue; } // Blank rows aren't stored
+
+                const uint8_t src_byte = char_start[old_row * bytes_per_char + old_col / BITS_PER_BYTE];
+                const uint8_t bit = (src_byte >> (BITS_PER_BYTE - 1 - (old_col % BITS_PER_BYTE))) & 1u;
+                rotated_byte |= bit << (BITS_PER_BYTE - 1 - k);
+            }
+            frame_draw_byte((x + (j * BITS_PER_BYTE)), (y + i), rotated_byte);
+        }
+    }
+}
+
+static void frame_draw_giant_char(int x, int y, uint32_t glyph)
+{
+    frame_draw_glyph(x, y, &font60, glyph);
+}
+
+/* Strings are recorded as one run, bounded by every character being a full width one that could have been
+ * pulled back by a period */
+static void frame_draw_rotated_string(int x, int y, const font_t *font, const char *str)
+{
+    const uint8_t bytes_per_row_rot = (font->height / BITS_PER_BYTE) + (font->height % BITS_PER_BYTE != 0);
+    FRAME_RECORD(x, y - (font->width / 2), bytes_per_row_rot * BITS_PER_BYTE, (strlen(str) + 1) * font->width,
+            .type = FRAME_OP_ROTATED_TEXT, .text = { x, y, frame_list_add_text(&frame_list, str), font });
+    while (str[0] != '\0')
+    {
+        /* Slightly cursed code to make periods look better */
+        y -= (str[0] == '.' && font->width < 20) ? ((font->width / 2) - 1) : 0;
+        frame_draw_rotated_char(x, y, font, *str);
+        y += (str[0] != '.') ? font->width : ((font->width / 2) + 2);
+        str++;
+    }
+}
+
+static void frame_draw_string(int x, int y, const font_t *font, const char *str)
+{
+    const uint8_t bytes_per_char = (font->width / BITS_PER_BYTE) + (font->width % BITS_PER_BYTE != 0);
+    FRAME_RECORD(x - (font->width / 2), y, (strlen(str) * font->width) + (bytes_per_char * BITS_PER_BYTE),
+            font->height,
+            .type = FRAME_OP_TEXT, .text = { x, y, frame_list_add_text(&frame_list, str), font });
+    while (str[0] != '\0')
+    {
+        /* Slightly cursed code to make periods look better */
+        x -= (str[0] == '.' && font->width < 20) ? ((font->width / 2) - 1) : 0;
+        frame_draw_char(x, y, font, *str);
+        x += (str[0] != '.') ? font->width : ((font->width / 2) + 2);
+        str++;
+    }
+}
+
+static void frame_draw_image(int x, int y, icon_t icon)
+{
+    FRAME_RECORD(x, y, icon.width, icon.height, .type = FRAME_OP_IMAGE, .image = { x, y, icon });
+    if (BAND_MISSES(y, icon.height))
+    {
+        return;
+    }
+    frame_blit(x, y, icon.data, icon.width / BITS_PER_BYTE, icon.height);
+}
+
+/* Used to draw degree symbol, unecessary, but I wanted to implement the midpoint circle algorithm */
+static void frame_draw_circle(int center_x, int center_y, int radius)
+{
+    int x = radius,
+        y = 0,
+        decision_over_2 = 1 - x; // Decision criterion divided by 2 evaluated at x=r, y=0
+
+    FRAME_RECORD(center_x - radius, center_y - radius, (2 * radius) + 2, (2 * radius) + 1, // 0xc0 is 2 pixels wide
+            .type = FRAME_OP_CIRCLE, .circle = { center_x, center_y, radius });
+    while (y <= x)
+    {
+        frame_draw_byte(center_x + x, center_y + y, 0xc0);
+        frame_draw_byte(center_x + y, center_y + x, 0xc0);
+        frame_draw_byte(center_x - x, center_y + y, 0xc0);
+        frame_draw_byte(center_x - y, center_y + x, 0xc0);
+        frame_draw_byte(center_x - x, center_y - y, 0xc0);
+        frame_draw_byte(center_x - y, center_y - x, 0xc0);
+        frame_draw_byte(center_x + x, center_y - y, 0xc0);
+        frame_draw_byte(center_x + y, center_y - x, 0xc0);
+        y++;
+        if (decision_over_2 <= 0) { decision_over_2 += 2 * y + 1; }
+        else                      { x--; decision_over_2 += 2 * (y - x) + 1; }
+    }
+}
+
+/* Fills pixels x0 to x1 inclusive of one row, a byte at a time with only the two end bytes masked */
+static void IRAM_ATTR frame_draw_span(int x0, int x1, int y)
+{
+    FRAME_RECORD(x0, y, x1 - x0 + 1, 1, .type = FRAME_OP_SPAN, .span = { x0, x1, y });
+    if (BAND_MISSES(y, 1))
+    {
+        return;
+    }
+    x0 = (x0 < 0) ? 0 : x0;
+    x1 = (x1 >= EPD_WIDTH) ? (EPD_WIDTH - 1) : x1;
+    if (x1 < x0)
+    {
+        return;
+    }
+    uint8_t *row = band[y - band_top];
+    const int first = x0 / BITS_PER_BYTE,
+              last = x1 / BITS_PER_BYTE;
+    const uint8_t left_mask = 0xFF >> (x0 % BITS_PER_BYTE),
+                  right_mask = 0xFF << ((BITS_PER_BYTE - 1) - (x1 % BITS_PER_BYTE));
+    if (first == last)
+    {
+        row[first] |= left_mask & right_mask;
+        return;
+    }
+    row[first] |= left_mask;
+    memset(&row[first + 1], 0xFF, last - first - 1);
+    row[last] |= right_mask;
+}
+
+/* Lines thicker than a pixel keep the pixels they had when they were drawn as copies of a 1px line offset
+ * below and above it: horizontal lines are that many rows tall and vertical ones that many columns wide, both
+ * without their end point, and diagonal ones are the 2px wide Bresenham line repeated over that many rows.
+ * Each row that covers is one contiguous span, so the extents are gathered for the rows in the band and then
+ * filled once */
+static void frame_draw_thick_line(int x0, int y0, int x1, int y1, int thickness)
+{
+    const int dx = abs(x1 - x0),
+              sx = x0 < x1 ? 1 : -1,
+              dy = -abs(y1 - y0),
+              sy = y0 < y1 ? 1 : -1;
+    const bool straight_line = (dx == 0 || dy == 0),
+               vertical = (dx == 0 && dy != 0);
+    /* Pixels stamped at each point of the line, from its x and its y */
+    const int pen_right = vertical ? (thickness - 1) : (straight_line ? 0 : 1),
+              pen_above = vertical ? 0 : (thickness - 1) / 2,
+              pen_below = vertical ? 0 : thickness / 2;
+    FRAME_RECORD((x0 < x1) ? x0 : x1, ((y0 < y1) ? y0 : y1) - pen_above, dx + pen_right + 1,
+            -dy + pen_above + pen_below + 1, .type = FRAME_OP_LINE, .line = { x0, y0, x1, y1, thickness });
+
+    const int first_row = ((((y0 < y1) ? y0 : y1) - pen_above) > band_top) ? (((y0 < y1) ? y0 : y1) - pen_above)
+                  : band_top,
+              last_row = ((((y0 > y1) ? y0 : y1) + pen_below) < (band_top + EPD_BAND_HEIGHT - 1)) ?
+                  (((y0 > y1) ? y0 : y1) + pen_below) : (band_top + EPD_BAND_HEIGHT - 1);
+    int16_t left[EPD_BAND_HEIGHT], right[EPD_BAND_HEIGHT];
+    int err = dx + dy, e2;
+
+    if (first_row > last_row)
+    {
+        return;
+    }
+    for (int row = first_row; row <= last_row; row++)
+    {
+        left[row - band_top] = INT16_MAX;
+        right[row - band_top] = INT16_MIN;
+    }
+    /* Bresenham, stamping the pen's rows at every point */
+    while (true)
+    {
+        if (straight_line && x0 == x1 && y0 == y1) break; // End point is excluded
+        int top = ((y0 - pen_above) > first_row) ? (y0 - pen_above) : first_row,
+            bottom = ((y0 + pen_below) < last_row) ? (y0 + pen_below) : last_row;
+        for (int row = top; row <= bottom; row++)
+        {
+            left[row - band_top] = (x0 < left[row - band_top]) ? x0 : left[row - band_top];
+            right[row - band_top] = ((x0 + pen_right) > right[row - band_top]) ? (x0 + pen_right)
+                : right[row - band_top];
+        }
+        if (x0 == x1 && y0 == y1) break;
+        e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+    for (int row = first_row; row <= last_row; row++)
+    {
+        if (left[row - band_top] <= right[row - band_top])
+        {
+            frame_draw_span(left[row - band_top], right[row - band_top], row);
+        }
+    }
+}
+
+/* Consecutive points joined with thick lines */
+static void frame_draw_polyline(const int points[][2], int count, int thickness)
+{
+    for (int i = 1; i < count; i++)
+    {
+        frame_draw_thick_line(points[i - 1][0], points[i - 1][1], points[i][0], points[i][1], thickness);
+    }
+}
+
+static void frame_draw_line(int x0, int y0, int x1, int y1, int thickness)
+{
+    if (thickness > 1)
+    {
+        frame_draw_thick_line(x0, y0, x1, y1, thickness);
+        return;
+    }
+    int dx  = abs(x1 - x0),
+        sx  = x0 < x1 ? 1 : -1,
+        dy  = -abs(y1 - y0),
+        sy  = y0 < y1 ? 1 : -1,
+        err = dx + dy,
+        e2;
+    bool straight_line = (dx == 0 || dy == 0);
+
+    /* Diagonal lines are drawn 2 pixels wide */
+    FRAME_RECORD((x0 < x1) ? x0 : x1, (y0 < y1) ? y0 : y1, dx + 2, -dy + 1,
+            .type = FRAME_OP_LINE, .line = { x0, y0, x1, y1, thickness });
+    /* For straight lines simply iterate over x/y to draw them */
+    if (straight_line)
+    {
+        if (dy == 0)
+        {
+            frame_draw_span((x0 < x1) ? x0 : (x1 + 1), (x0 < x1) ? (x1 - 1) : x0, y0); // End point is excluded
+        } else {
+            while (y0 != y1)
+            {
+                frame_draw_byte(x0, y0, 0x80);
+                y0 += sy;
+            }
+        }
+    } else {
+        /* Bresenham Line Drawing Algorithm for non straight lines */
+        while (true)
+        {
+            frame_draw_byte(x0, y0, 0xc0);
+            if (x0 == x1 && y0 == y1) break;
+            e2 = 2 * err;
+            if (e2 >= dy)
+            {
+                err += dy;
+                x0 += sx;
+            }
+            if (e2 <= dx)
+            {
+                err += dx;
+                y0 += sy;
+            }
+        }
+    }
+}
+
+/* ORs a pattern into the rectangle from (x0, y0) to (x1, y1) inclusive, a whole byte at a time. The pattern is
+ * period bytes long and repeats across every row, anchored to byte 0 of the screen rather than to x0 */
+static void IRAM_ATTR frame_fill_pattern(int x0, int y0, int x1, int y1, const uint8_t *pattern, int period)
+{
+    FRAME_RECORD(x0, y0, x1 - x0 + 1, y1 - y0 + 1,
+            .type = FRAME_OP_PATTERN, .pattern = { x0, y0, x1, y1, period, pattern });
+    x0 = (x0 < 0) ? 0 : x0;
+    x1 = (x1 >= EPD_WIDTH) ? (EPD_WIDTH - 1) : x1;
+    y0 = (y0 > band_top) ? y0 : band_top;
+    y1 = (y1 < (band_top + EPD_BAND_HEIGHT - 1)) ? y1 : (band_top + EPD_BAND_HEIGHT - 1);
+    if (x1 < x0 || y1 < y0)
+    {
+        return;
+    }
+    const int first = x0 / BITS_PER_BYTE,
+              last = x1 / BITS_PER_BYTE;
+    const uint8_t left_mask = 0xFF >> (x0 % BITS_PER_BYTE),
+                  right_mask = 0xFF << ((BITS_PER_BYTE - 1) - (x1 % BITS_PER_BYTE));
+
+    for (int y = y0; y <= y1; y++)
+    {
+        uint8_t *row = band[y - band_top];
+        for (int byte = first; byte <= last; byte++)
+        {
+            uint8_t bits = pattern[byte % period];
+            bits &= (byte == first) ? left_mask : 0xFF;
+            bits &= (byte == last) ? right_mask : 0xFF;
+            row[byte] |= bits;
+        }
+    }
+}
+
+/* Every third column set, 24 bits is the shortest run of whole bytes the pattern repeats in. Starting
+ * from pattern byte n shifts the columns right by n, which lines the hatching up with any x */
+static const uint8_t hatch_pattern[] = {0x92, 0x49, 0x24, 0x92, 0x49};
+#define HATCH_PERIOD 3
+
+/* Draws a rectangle hatched with vertical lines */
+static void frame_draw_dotted_rectangle(int left, int top, int right, int bottom, int thickness)
+{
+    frame_draw_line(left, top, left, bottom, thickness);
+    frame_draw_line(right, top, right, bottom, thickness);
+    frame_draw_line(left, top, right, top, thickness);
+    frame_draw_line(left, bottom, right, bottom, thickness);
+    /* Hatching a column in every 3 starting at left, the same as a 1px line from top to bottom at each */
+    frame_fill_pattern(left, top, right - 1, bottom - 1, &hatch_pattern[left % HATCH_PERIOD], HATCH_PERIOD);
+}
+
+/* Triangle edge walked one row at a time, with x kept exactly as x + (remainder / height) so there's
+ * no rounding to accumulate and no floating point */
+typedef struct
+{
+    int x, step, remainder, remainder_step, height;
+} frame_edge_t;
+
+static int floor_div(int numerator, int denominator)
+{
+    return (numerator / denominator) - ((numerator % denominator) < 0);
+}
+
+/* Starts the edge from (x0, y0) to (x1, y1) at row y, with y0 < y1 */
+static void frame_edge_init(frame_edge_t *edge, int x0, int y0, int x1, int y1, int y)
+{
+    const int dx = x1 - x0,
+              offset = dx * (y - y0);
+    edge->height = y1 - y0;
+    edge->step = floor_div(dx, edge->height);
+    edge->remainder_step = dx - (edge->step * edge->height);
+    edge->x = x0 + floor_div(offset, edge->height);
+    edge->remainder = offset - ((edge->x - x0) * edge->height);
+}
+
+static bool frame_edge_less(const frame_edge_t *a, const frame_edge_t *b)
+{
+    return a->x < b->x || (a->x == b->x && (a->remainder * b->height) < (b->remainder * a->height));
+}
+
+static void frame_edge_step(frame_edge_t *edge)
+{
+    edge->x += edge->step;
+    edge->remainder += edge->remainder_step;
+    if (edge->remainder >= edge->height)
+    {
+        edge->x++;
+        edge->remainder -= edge->height;
+    }
+}
+
+static void frame_draw_filled_triangle(int x0, int y0, int x1, int y1, int x2, int y2)
+{
+    /* Sort the vertices by y-coordinate ascending (y0 <= y1 <= y2) */
+    if (y0 > y1) { int t=x0; x0=x1; x1=t; t=y0; y0=y1; y1=t; }
+    if (y0 > y2) { int t=x0; x0=x2; x2=t; t=y0; y0=y2; y2=t; }
+    if (y1 > y2) { int t=x1; x1=x2; x2=t; t=y1; y1=y2; y2=t; }
+    int total_h = y2 - y0,
+        min_x = (x0 < x1) ? ((x0 < x2) ? x0 : x2) : ((x1 < x2) ? x1 : x2),
+        max_x = (x0 > x1) ? ((x0 > x2) ? x0 : x2) : ((x1 > x2) ? x1 : x2);
+    FRAME_RECORD(min_x, y0, max_x - min_x + 1, total_h + 1,
+            .type = FRAME_OP_TRIANGLE, .triangle = { x0, y0, x1, y1, x2, y2 });
+    if (total_h == 0)
+    {
+        frame_draw_span(min_x, max_x, y0);
+        return;
+    }
+
+    /* Scanline algorithm, only walking the rows inside the band. The long edge goes from vertex 0 to 2,
+     * the short side is edge 0 to 1 down to row y1 and edge 1 to 2 after it */
+    const int first_row = (y0 > band_top) ? y0 : band_top,
+              last_row = (y2 < (band_top + EPD_BAND_HEIGHT - 1)) ? y2 : (band_top + EPD_BAND_HEIGHT - 1);
+    frame_edge_t long_edge, short_edge;
+    bool upper = (first_row < y1);
+
+    if (first_row > last_row)
+    {
+        return;
+    }
+    /* With a flat bottom the lower edge only covers row y1, stretching it a row keeps the division valid */
+    const int lower_y2 = (y2 > y1) ? y2 : (y1 + 1);
+    frame_edge_init(&long_edge, x0, y0, x2, y2, first_row);
+    if (upper)
+    {
+        frame_edge_init(&short_edge, x0, y0, x1, y1, first_row);
+    } else {
+        frame_edge_init(&short_edge, x1, y1, x2, lower_y2, first_row);
+    }
+    for (int y = first_row; y <= last_row; y++)
+    {
+        if (upper && y == y1)
+        {
+            upper = false;
+            frame_edge_init(&short_edge, x1, y1, x2, lower_y2, y);
+        }
+        /* Pixels from the left edge rounded up to the right edge rounded down */
+        const frame_edge_t *left = &long_edge,
+                           *right = &short_edge;
+        if (frame_edge_less(right, left))
+        {
+            left = &short_edge;
+            right = &long_edge;
+        }
+        frame_draw_span(left->x + (left->remainder != 0), right->x, y);
+        frame_edge_step(&long_edge);
+        frame_edge_step(&short_edge);
+    }
+}
+
+/* Draws a recorded operation into the current band with the primitive that recorded it */
+static void frame_replay(const frame_op_t *op)
+{
+    switch (op->type)
+    {
+        case FRAME_OP_TEXT:
+            frame_draw_string(op->text.x, op->text.y, op->text.font, &frame_list.text[op->text.text]); break;
+        case FRAME_OP_ROTATED_TEXT:
+            frame_draw_rotated_string(op->text.x, op->text.y, op->text.font, &frame_list.text[op->text.text]); break;
+        case FRAME_OP_GLYPH:
+            frame_draw_glyph(op->glyph.x, op->glyph.y, op->glyph.font, op->glyph.index); break;
+        case FRAME_OP_ROTATED_CHAR:
+            frame_draw_rotated_char(op->glyph.x, op->glyph.y, op->glyph.font, op->glyph.index); break;
+        case FRAME_OP_IMAGE:
+            frame_draw_image(op->image.x, op->image.y, op->image.icon); break;
+        case FRAME_OP_CIRCLE:
+            frame_draw_circle(op->circle.x, op->circle.y, op->circle.radius); break;
+        case FRAME_OP_SPAN:
+            frame_draw_span(op->span.x0, op->span.x1, op->span.y); break;
+        case FRAME_OP_LINE:
+            frame_draw_line(op->line.x0, op->line.y0, op->line.x1, op->line.y1, op->line.thickness); break;
+        case FRAME_OP_PATTERN:
+            frame_fill_pattern(op->pattern.x0, op->pattern.y0, op->pattern.x1, op->pattern.y1,
+                    op->pattern.pattern, op->pattern.period); break;
+        case FRAME_OP_TRIANGLE:
+            frame_draw_filled_triangle(op->triangle.x0, op->triangle.y0, op->triangle.x1, op->triangle.y1,
+                    op->triangle.x2, op->triangle.y2); break;
+    }
+}
+
+static void frame_draw_arrow(int x, int y, uint16_t degrees, int length)
+{
+    int points[3][2];
+    fixed_arrow(x, y, degrees, length, points);
+    frame_draw_thick_line(x, y, points[0][0], points[0][1], 2);
+    frame_draw_filled_triangle(points[0][0], points[0][1], points[1][0], points[1][1], points[2][0], points[2][1]);
+}
+
+static void frame_draw_time(int x, int y)
+{
+    uint16_t hour = ((timeinfo.tm_hour % 12) == 0) ? 12 : (timeinfo.tm_hour % 12),
+             minute = timeinfo.tm_min,
+             afternoon = (timeinfo.tm_hour >= 12) ? 0 : 1;
+
+    uint8_t time[] =
+    {
+        (hour / 10) % 10,
+        hour % 10,
+        10, // ':' character
+        (minute / 10) % 10,
+        minute % 10,
+        afternoon ? 11 : 12,
+        13 // 'M' character
+    };
+
+    for (int i = 0; i < (int)sizeof(time); i++)
+    {
+        switch (time[i])
+        {
+            case 0:  frame_draw_giant_char(x + (i * font60.width), y, ZERO); break;
+            case 1:  frame_draw_giant_char(x + (i * font60.width), y, ONE); break;
+            case 2:  frame_draw_giant_char(x + (i * font60.width), y, TWO); break;
+            case 3:  frame_draw_giant_char(x + (i * font60.width), y, THREE); break;
+            case 4:  frame_draw_giant_char(x + (i * font60.width), y, FOUR); break;
+            case 5:  frame_draw_giant_char(x + (i * font60.width), y, FIVE); break;
+            case 6:  frame_draw_giant_char(x + (i * font60.width), y, SIX); break;
+            case 7:  frame_draw_giant_char(x + (i * font60.width), y, SEVEN); break;
+            case 8:  frame_draw_giant_char(x + (i * font60.width), y, EIGHT); break;
+            case 9:  frame_draw_giant_char(x + (i * font60.width), y, NINE); break;
+            case 10: frame_draw_giant_char(x + (i * font60.width), y, COLON); break;
+            case 11: frame_draw_giant_char(x + (i * font60.width), y, LETTER_A); break;
+            case 12: frame_draw_giant_char(x + (i * font60.width), y, LETTER_P); break;
+            case 13: frame_draw_giant_char(x + (i * font60.width), y, LETTER_M); break;
+        }
+    }
+}
+
+static void frame_draw_icon(int x, int y, uint16_t weather_id, bool small_image)
+{
+    bool is_daytime = (timeinfo.tm_hour >= 6 && timeinfo.tm_hour < 18);
+    icon_t icon;
+
+    /* Weather condition codes documented at https://openweathermap.org/weather-conditions */
+    switch (weather_id)
+    {
+        case THUNDERSTORM_START ... THUNDERSTORM_END:
+            icon = small_image ? thunder_small : thunder; break;
+        case DRIZZLE_START ... DRIZZLE_END:
+            icon = small_image ? drizzle_small : drizzle; break;
+        case RAIN_START ... RAIN_END:
+            icon = small_image ? rain_small : rain; break;
+        case SNOW_START ... SNOW_END:
+            icon = small_image ? snow_small : snow; break;
+        case ATMOSPHERE_START ... ATMOSPHERE_END:
+            icon = small_image ? haze_small : haze; break;
+        case CLEAR_SKY:
+            icon = (small_image) ? sun_small : ((is_daytime) ? sun : moon); break;
+        case CLOUDS_START ... CLOUDS_END:
+            icon = small_image ? cloud_small : cloud; break;
+        default:
+            ESP_LOGE("icon", "Unknown weather id: %d, using default cloud icon", weather_id);
+            icon = small_image ? cloud_small : cloud; break;
+    }
+    frame_draw_image(x, y, icon);
+}
+
+static int32_t to_hundredths(float value)
+{
+    return (int32_t)((value * 100.0f) + ((value < 0) ? -0.5f : 0.5f));
+}
+
+/* Draw graph of two sets of points with the same y-axes, used for the temperature and precipitation forecast graph
+ * first series of points is drawn with a solid line and the second series is drawn with as dashed boxes. The axes,
+ * grid and y-axis labels never change so they're part of the chrome, see frame_draw_chrome() */
+static void frame_draw_graph(int left, int top, int right, int bottom, float min_value, float max_value,
+        struct hourly_forecast hourly_forecast[], int num_points)
+{
+    /* Y axis increases as you go down the screen */
+    int    graph_width       = abs(right - left),
+           graph_height      = abs(bottom - top),
+           x_space           = graph_width / (num_points - 1),
+           x_error           = graph_width - (x_space * (num_points - 1));
+    /* Points are scaled onto the graph in hundredths, the values only come with two decimal places */
+    int32_t min_scaled       = to_hundredths(min_value),
+            max_scaled       = to_hundredths(max_value);
+    int     temperature[num_points][2];
+
+    for (int i = 0; i < num_points; i++)
+    {
+        int x = (i < (num_points - 1)) ? (x_space * i) + left : (x_space * i) + x_error + left;
+        /* Draw x-axis time labels rotated otherwise they overlap with each other */
+        frame_draw_rotated_string(x - 8, bottom + 8, &font12, hourly_forecast[i].time);
+    }
+
+    for (int i = 1; i < num_points; i++)
+    {
+        int temp_y      = bottom
+                - fixed_map(to_hundredths(hourly_forecast[i].temp), min_scaled, max_scaled, graph_height),
+            temp_y_prev = bottom
+                - fixed_map(to_hundredths(hourly_forecast[i - 1].temp), min_scaled, max_scaled, graph_height),
+            precip_y    = bottom
+                - fixed_map(to_hundredths(hourly_forecast[i].precipitation_chance), min_scaled, max_scaled, graph_height),
+            x           = (i < (num_points - 1)) ? (x_space * i) + left : (x_space * i) + x_error + left,
+            x_prev      = (x_space * (i - 1)) + left;
+
+        /* Temperature line is drawn once all its points are known */
+        temperature[i - 1][0] = x_prev;
+        temperature[i - 1][1] = temp_y_prev;
+        temperature[i][0] = x;
+        temperature[i][1] = temp_y;
+
+        if (precip_y < bottom)
+        {
+            frame_draw_dotted_rectangle(x_prev, precip_y, x, bottom, 1);
+        }
+    }
+    frame_draw_polyline(temperature, num_points, 3);
+}
+
+/* Formats into the caller's buffer rather than a static one, as both cores run the drawing code at once when
+ * frame_render_default() can't replay the list */
+#define FLOAT_STRING_SIZE 16
+
+static char *float_to_string(float value, char buffer[FLOAT_STRING_SIZE])
+{
+    if ((int)value == value)
+    {
+        snprintf(buffer, FLOAT_STRING_SIZE, "%d", (int)value); // Trim trailing .0 for whole numbers
+    } else {
+        snprintf(buffer, FLOAT_STRING_SIZE, "%.1f", value);
+    }
+    return buffer;
+}
+
+static uint16_t float_str_width(float value, uint16_t font_width)
+{
+    char str[FLOAT_STRING_SIZE];
+    float_to_string(value, str);
+    uint16_t str_width = strlen(str) * font_width;
+    if (font_width <= 22)
+    {
+        str_width -= (strchr(str, '.') != NULL) ? font_width : 0;
+    } else {
+        str_width -= (strchr(str, '.') != NULL) ? ((font_width * 35) + 99) / 100 : 0; // 0.35 of a character, rounded up
+    }
+    return str_width;
+}
+
+static void frame_draw_forecast(int x, int y, struct weather_forecast forecast)
+{
+    char text[FLOAT_STRING_SIZE];
+    frame_draw_string(x, y, &font24, forecast.day);
+    frame_draw_icon(x, y + 30, forecast.id, true);
+    frame_draw_string(x + 70, y + 30, &font16, float_to_string(forecast.high_temp, text));
+    frame_draw_circle((x + 72 + float_str_width(forecast.high_temp, font16.width)), y + 25, 2);
+    frame_draw_string(x + 70, y + 50, &font16, float_to_string(forecast.low_temp, text));
+    frame_draw_circle((x + 72 + float_str_width(forecast.low_temp, font16.width)), y + 45, 2);
+    if (forecast.precipitation_chance > 0)
+    {
+        frame_draw_image(x + 42, y + 70, raindrop);
+        frame_draw_string(x + 68, y + 70, &font16, float_to_string(forecast.precipitation_chance, text));
+        frame_draw_string(x + 68 + float_str_width(forecast.precipitation_chance, font16.width), y + 70,
+                &font12, "%");
+    }
+}
+
+static void frame_draw_battery(int left, int top, int right, int bottom, uint8_t percentage)
+{
+    char text[FLOAT_STRING_SIZE];
+    int tail_width = (right - left) / 10,
+        tail_height = (bottom - top) / 3,
+        body_width = (right - left) - tail_width,
+        body_height = bottom - top,
+        fill_point = (int)((percentage / 100.0f) * body_width);
+    /* Draw battery body, lines leave out their end point so the bottom runs on to close the corner */
+    frame_draw_line(left, top, left, bottom, 2);
+    frame_draw_line(left, top, left + body_width, top, 2);
+    frame_draw_line(left + body_width, top, left + body_width, bottom, 2);
+    frame_draw_line(left, bottom, left + body_width + 2, bottom, 2);
+    /* Draw battery tail */
+    frame_draw_line(right - tail_width, top + tail_height, right, top + tail_height, 2);
+    frame_draw_line(right - tail_width,
+            top + tail_height + tail_height, right + 2, top + tail_height + tail_height, 2);
+    frame_draw_line(right, top + tail_height, right, top + tail_height + tail_height, 2);
+    /* Draw battery level */
+    for (int i = top; i < bottom; i++)
+    {
+        frame_draw_span(left, left + fill_point - 1, i);
+    }
+    frame_draw_string(right + 4, top + 2, &font12, float_to_string(percentage, text));
+     frame_draw_string(right + 4 + float_str_width(percentage, font12.width), top + 2, &font12, "%");
+}
+
+#if defined(FRAME_CHROME_GENERATOR)
+/* Labels, icons and anything else that never changes, drawn next to the widgets they belong with by the
+ * primitives above. Only built for tools/frame_preview, which renders it into src/frame_chrome.c */
+static void frame_draw_chrome(void)
+{
+    /* Date widget */
+    frame_draw_string(450, 20, &font24, "It is ");
+
+    /* Current conditions widget */
+    frame_draw_string(10, 130, &font20, "Currently, ");
+    frame_draw_string(140, 180, &font20, "feels like");
+    frame_draw_string(175, 20, &font24, "High");
+    frame_draw_arrow(185 + (4 * font24.width), 40, 0, 20);
+    frame_draw_string(175, 50, &font24, " Low");
+    frame_draw_arrow(185 + (4 * font24.width), 50, 179, 20);
+    frame_draw_string(175, 80, &font16, "Wind");
+    frame_draw_string(175, 95, &font16, "Speed");
+    frame_draw_image(235, 75, wind);
+    frame_draw_string(175, 125, &font16, "Cloud");
+    frame_draw_string(175, 140, &font16, "Cover");
+    frame_draw_image(240, 120, cloud_small);
+    /* Compass face, the arrow in it is drawn with the wind direction */
+    const int compass_x = 400, compass_y = 100, compass_length = 15;
+    frame_draw_circle(compass_x, compass_y, compass_length);
+    frame_draw_string(compass_x - (font16.width / 2), compass_y - compass_length - font16.height, &font16, "N");
+    frame_draw_string(compass_x + compass_length + 4, compass_y - (font16.height / 2), &font16, "E");
+    frame_draw_string(compass_x - (font16.width / 2) + 2, compass_y + compass_length + 2, &font16, "S");
+    frame_draw_string(compass_x - compass_length - font16.width - 2, compass_y - (font16.height / 2), &font16, "W");
+
+    /* Graph widget, everything but the time labels and the data */
+    const int left = 42, top = 240, right = 384, bottom = 430, num_points = FORECAST_HOURS, lines_y = 10;
+    int x_space = (right - left) / (num_points - 1),
+        x_error = (right - left) - (x_space * (num_points - 1)),
+        y_spacing = (bottom - top) / lines_y;
+    /* |_| shaped graph, the sides run on past the bottom to close its corners */
+    frame_draw_line(left, top, left, bottom + 1, 2);
+    frame_draw_line(left, bottom, right, bottom, 2);
+    frame_draw_line(right, top, right, bottom + 2, 2);
+    for (int i = 0; i < num_points; i++)
+    {
+        int x = (i < (num_points - 1)) ? (x_space * i) + left : (x_space * i) + x_error + left;
+        frame_draw_line(x, bottom, x, top, 1);
+    }
+    for (int i = 0; i <= lines_y; i++)
+    {
+        char label[8];
+        int value = (100 / lines_y) * i,
+            y = bottom - (i * y_spacing);
+        frame_draw_line(left, y, right, y, 1);
+        snprintf(label, sizeof(label), "%dF", value);
+        frame_draw_string(left - (font12.width * strlen(label)) - 14, y - 6, &font12, label);
+        frame_draw_circle(left - 12, y - 8, 2);
+        snprintf(label, sizeof(label), "%d%%", value);
+        frame_draw_string(right + 4, y - 6, &font12, label);
+    }
+
+    /* Forecast cards, the high and low arrows */
+    for (int card = 0; card < 6; card++)
+    {
+        int x = 445 + ((card % 3) * 120),
+            y = 235 + ((card / 3) * 125);
+        frame_draw_arrow(x + 60, y + 45, 0, 15);
+        frame_draw_arrow(x + 60, y + 45, 179, 15);
+    }
+}
+#endif
+
+/* Quadrant 1: Current date, the time below it is its own widget as it changes far more often */
+static void widget_draw_date(int index)
+{
+    (void)index;
+    char timeinfo_str[64];
+    strftime(timeinfo_str, sizeof(timeinfo_str), "%A,", &timeinfo);
+    frame_draw_string(450 + (font24.width * strlen("It is ")), 20, &font24, timeinfo_str);
+    strftime(timeinfo_str, sizeof(timeinfo_str), "%B %d, %Y", &timeinfo);
+    frame_draw_string(470, 50, &font24, timeinfo_str);
+}
+
+static void widget_draw_clock(int index)
+{
+    (void)index;
+    frame_draw_time(CLOCK_X, CLOCK_Y);
+}
+
+static void widget_draw_battery(int index)
+{
+    (void)index;
+    frame_draw_battery(730, 5, 770, 20, battery_percentage);
+}
+
+/* Quadrant 2: Current weather conditions */
+static void widget_draw_current(int index)
+{
+    (void)index;
+    char text[FLOAT_STRING_SIZE];
+    frame_draw_icon(20, 20, weather.id, false);
+    frame_draw_string(30, 160, &font40, float_to_string(weather.current_temp, text));
+    frame_draw_circle(30 + float_str_width(weather.current_temp, font40.width), 165, 5);
+    frame_draw_string(290, 176, &font24, float_to_string(weather.feels_like_temp, text));
+    frame_draw_circle((292 + float_str_width(weather.feels_like_temp, font24.width)), 176, 3);
+    frame_draw_string(260, 20, &font24, float_to_string(weather.high_temp, text));
+    frame_draw_circle((262 + float_str_width(weather.high_temp, font24.width)), 20, 3);
+    frame_draw_string(260, 50, &font24, float_to_string(weather.low_temp, text));
+    frame_draw_circle((262 + float_str_width(weather.low_temp, font24.width)), 50, 3);
+    frame_draw_string(285, 85, &font24, float_to_string(weather.wind_speed, text));
+    frame_draw_string((288 + float_str_width(weather.wind_speed, font24.width)), 90, &font12, "mph");
+    frame_draw_arrow(400, 100, weather.wind_direction_degrees, 15); // Compass face is in the chrome
+    frame_draw_string(295, 130, &font24, float_to_string(weather.cloudiness, text));
+    frame_draw_string(295 + float_str_width(weather.cloudiness, font24.width), 125, &font20, "%");
+}
+
+/* Quadrant 3: Graph showing temperature and precipitaion chance */
+static void widget_draw_graph(int index)
+{
+    (void)index;
+    frame_draw_graph(42, 240, 384, 430, 0, 100, hourly_forecast, FORECAST_HOURS);
+}
+
+/* Quadrant 4: Forecast for next few days, in two rows of three cards */
+static void widget_draw_forecast(int index)
+{
+    frame_draw_forecast(445 + (((index - 1) % 3) * 120), 235 + (((index - 1) / 3) * 125), forecast[index]);
+}
+
+/* FNV-1a, only used to notice when a widget's inputs change so it doesn't need to be any stronger */
+#define HASH_SEED   2166136261u
+#define HASH_PRIME  16777619u
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * HASH_PRIME;
+    }
+    return hash;
+}
+
+static uint32_t widget_hash_date(int index)
+{
+    (void)index;
+    const int date[] = { timeinfo.tm_year, timeinfo.tm_mon, timeinfo.tm_mday, timeinfo.tm_wday };
+    return hash_bytes(HASH_SEED, date, sizeof(date));
+}
+
+static uint32_t widget_hash_clock(int index)
+{
+    (void)index;
+    const int time[] = { timeinfo.tm_hour, timeinfo.tm_min };
+    return hash_bytes(HASH_SEED, time, sizeof(time));
+}
+
+static uint32_t widget_hash_battery(int index)
+{
+    (void)index;
+    return hash_bytes(HASH_SEED, &battery_percentage, sizeof(battery_percentage));
+}
+
+static uint32_t widget_hash_current(int index)
+{
+    (void)index;
+    const bool is_daytime = (timeinfo.tm_hour >= 6 && timeinfo.tm_hour < 18); // Picks the sun or moon icon
+    return hash_bytes(hash_bytes(HASH_SEED, &weather, sizeof(weather)), &is_daytime, sizeof(is_daytime));
+}
+
+static uint32_t widget_hash_graph(int index)
+{
+    (void)index;
+    return hash_bytes(HASH_SEED, hourly_forecast, sizeof(hourly_forecast));
+}
+
+static uint32_t widget_hash_forecast(int index)
+{
+    return hash_bytes(HASH_SEED, &forecast[index], sizeof(forecast[index]));
+}
+
+/* The screen is split into widgets that each draw only from their own inputs. Hashes of the inputs are kept
+ * in RTC memory alongside the previous frame, and any band that only holds widgets whose inputs hash the
+ * same is taken from the previous frame rather than being drawn again */
+typedef struct
+{
+    void (*draw)(int index);
+    uint32_t (*hash)(int index);
+    int index; // Day shown by forecast cards
+} widget_t;
+
+static const widget_t widgets[] =
+{
+    { widget_draw_date,     widget_hash_date,     0 },
+    { widget_draw_clock,    widget_hash_clock,    0 },
+    { widget_draw_battery,  widget_hash_battery,  0 },
+    { widget_draw_current,  widget_hash_current,  0 },
+    { widget_draw_graph,    widget_hash_graph,    0 },
+    { widget_draw_forecast, widget_hash_forecast, 1 },
+    { widget_draw_forecast, widget_hash_forecast, 2 },
+    { widget_draw_forecast, widget_hash_forecast, 3 },
+    { widget_draw_forecast, widget_hash_forecast, 4 },
+    { widget_draw_forecast, widget_hash_forecast, 5 },
+    { widget_draw_forecast, widget_hash_forecast, 6 },
+};
+#define WIDGETS ((int)(sizeof(widgets) / sizeof(widgets[0])))
+
+/* Input hashes of the widgets on the display and the box around what each drew there, and the same for the
+ * ones being drawn now. Bounds come from the operations each widget records, so a widget whose inputs
+ * changed is sent as what it drew before together with what it draws now. The display is drawn over by
+ * error messages, and its contents are unknown after a cold boot */
+static RTC_FAST_ATTR uint32_t widget_hashes[WIDGETS] = {0};
+static RTC_FAST_ATTR epd_rect_t widget_bounds[WIDGETS] = {0};
+static RTC_FAST_ATTR bool widget_hashes_valid = false;
+static uint32_t widget_pending_hashes[WIDGETS];
+static epd_rect_t widget_pending_bounds[WIDGETS];
+static frame_damage_t widget_changes;
+
+static void frame_draw_default()
+{
+    for (int i = 0; i < WIDGETS; i++)
+    {
+        widgets[i].draw(widgets[i].index);
+    }
+}
+
+const frame_damage_t *widget_check_inputs(void)
+{
+    frame_damage_reset(&widget_changes);
+    for (int i = 0; i < WIDGETS; i++)
+    {
+        widget_pending_hashes[i] = widgets[i].hash(widgets[i].index);
+        if (widget_pending_hashes[i] != widget_hashes[i])
+        {
+            frame_damage_add(&widget_changes, widget_bounds[i].x, widget_bounds[i].y,
+                    widget_bounds[i].width, widget_bounds[i].height);
+            frame_damage_add(&widget_changes, widget_pending_bounds[i].x, widget_pending_bounds[i].y,
+                    widget_pending_bounds[i].width, widget_pending_bounds[i].height);
+        }
+    }
+    if (!widget_hashes_valid)
+    {
+        ESP_LOGI("widget", "Display contents unknown, every widget is redrawn");
+        return NULL;
+    }
+    ESP_LOGI("widget", "Changed widgets cover %lu pixels", (unsigned long)frame_damage_area(&widget_changes));
+    return &widget_changes;
+}
+
+void widget_commit_inputs(void)
+{
+    memcpy(widget_hashes, widget_pending_hashes, sizeof(widget_hashes));
+    memcpy(widget_bounds, widget_pending_bounds, sizeof(widget_bounds));
+    widget_hashes_valid = true;
+}
+
+void widget_invalidate_inputs(void)
+{
+    widget_hashes_valid = false;
+}
+
+void frame_record_default(void)
+{
+    frame_damage_reset(&damage);
+    frame_list_reset(&frame_list);
+    band = NULL;
+    for (int i = 0; i < WIDGETS; i++)
+    {
+        frame_damage_reset(&widget_damage);
+        widgets[i].draw(widgets[i].index);
+        widget_pending_bounds[i] = frame_damage_bounds(&widget_damage);
+    }
+    ESP_LOGI("frame", "%d operations recorded%s, %d damage regions covering %lu pixels", frame_list.count,
+            frame_list.overflow ? " but some didn't fit" : "", damage.count, (unsigned long)frame_damage_area(&damage));
+}
+
+void frame_render_default(uint8_t *buffer, int top)
+{
+    for (int row = 0; row < EPD_BAND_HEIGHT; row++)
+    {
+        if (frame_chrome_index[top + row] != FRAME_CHROME_BLANK)
+        {
+            memcpy(buffer + (row * EPD_BYTE_WIDTH), frame_chrome_rows[frame_chrome_index[top + row]],
+                    EPD_BYTE_WIDTH);
+        }
+    }
+    if (!frame_damage_intersects(&damage, top, EPD_BAND_HEIGHT))
+    {
+        return; // Nothing else is drawn here
+    }
+    band = (uint8_t (*)[EPD_BYTE_WIDTH])buffer;
+    band_top = top;
+    if (frame_list.overflow)
+    {
+        frame_draw_default(); // Incomplete list, run the drawing code for this band instead
+        return;
+    }
+    for (int i = 0; i < frame_list.count; i++)
+    {
+        if (frame_list_reaches(&frame_list.ops[i], top, EPD_BAND_HEIGHT))
+        {
+            frame_replay(&frame_list.ops[i]);
+        }
+    }
+}
+
+#if defined(FRAME_CHROME_GENERATOR)
+void frame_render_chrome(uint8_t *buffer, int top)
+{
+    band = (uint8_t (*)[EPD_BYTE_WIDTH])buffer;
+    band_top = top;
+    frame_draw_chrome();
+}
+#endif
+
+void frame_render_message(uint8_t *buffer, int top, const char *message)
+{
+    band = (uint8_t (*)[EPD_BYTE_WIDTH])buffer;
+    band_top = top;
+    /* Draw error message in the middle of the screen */
+    int x = (EPD_WIDTH - (strlen(message) * font40.width)) / 2;
+    int y = (EPD_HEIGHT - font40.height) / 2;
+    frame_draw_string(x, y, &font40, message);
+}
+
+#if defined(FRAME_BENCHMARK)
+/* Every primitive timed on its own, then the whole frame. Each benchmark draws into every band it reaches as
+ * replaying does, keeps the best of a few runs and takes off what clearing those bands costs. Enabled with
+ * idf.py -DFRAME_BENCHMARK=1 build, or -DFRAME_BENCHMARK=ON for tools/frame_preview on the host */
+#define BENCHMARK_RUNS 10
+
+typedef struct
+{
+    const char *name;
+    void (*draw)(void);
+    int calls; // Calls to the primitive per run of draw
+    int top;
+    int height; // Rows the drawing reaches
+    bool bytewise; // See benchmark_bytewise
+} frame_benchmark_t;
+
+static void benchmark_byte(void)
+{
+    for (int i = 0; i < 200; i++)
+    {
+        frame_draw_byte(3 + ((i * 8) % 784), 100 + (i % 20), 0xa5); // Unaligned, so two bytes are written
+    }
+}
+
+static void benchmark_char(void)
+{
+    for (int i = 0; i < 40; i++)
+    {
+        frame_draw_char(10 + ((i % 20) * font24.width), 100 + ((i / 20) * font24.height), &font24, 'A' + i);
+    }
+}
+
+static void benchmark_rotated_char(void)
+{
+    for (int i = 0; i < 40; i++)
+    {
+        frame_draw_rotated_char(10 + (i * 16), 100, &font12, 'A' + i);
+    }
+}
+
+static void benchmark_rotated_char_bitwise(void)
+{
+    for (int i = 0; i < 40; i++)
+    {
+        frame_draw_rotated_char(10 + (i * 16), 100, &font16, 'A' + i); // No rotated table
+    }
+}
+
+static void benchmark_giant_char(void)
+{
+    for (int i = 0; i < 7; i++)
+    {
+        frame_draw_giant_char(CLOCK_X + (i * font60.width), 100, ZERO + i);
+    }
+}
+
+static void benchmark_image(void)
+{
+    const icon_t icons[] = { cloud, drizzle, rain, thunder, haze, snow };
+    for (int i = 0; i < 6; i++)
+    {
+        frame_draw_image(10 + (i * 130), 100, icons[i]);
+    }
+}
+
+static void benchmark_line_horizontal(void)
+{
+    for (int i = 0; i < 40; i++)
+    {
+        frame_draw_line(10, 100 + i, 790, 100 + i, 1);
+    }
+}
+
+static void benchmark_line_vertical(void)
+{
+    for (int i = 0; i < 40; i++)
+    {
+        frame_draw_line(10 + (i * 19), 100, 10 + (i * 19), 200, 1);
+    }
+}
+
+static void benchmark_line(int thickness)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        frame_draw_line(10 + (i * 30), 100, 200 + (i * 30), 200, thickness);
+    }
+}
+
+static void benchmark_line_1(void) { benchmark_line(1); }
+static void benchmark_line_2(void) { benchmark_line(2); }
+static void benchmark_line_3(void) { benchmark_line(3); }
+
+static void benchmark_triangle(void)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        frame_draw_filled_triangle(10 + (i * 38), 100, 40 + (i * 38), 130, 10 + (i * 38), 160);
+    }
+}
+
+static void benchmark_circle(void)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        frame_draw_circle(20 + (i * 38), 120, 15);
+    }
+}
+
+static void benchmark_graph(void)
+{
+    frame_draw_graph(42, 240, 384, 430, 0, 100, hourly_forecast, FORECAST_HOURS);
+}
+
+static void benchmark_render_default(void)
+{
+    frame_render_default((uint8_t *)band, band_top);
+}
+
+static const frame_benchmark_t benchmarks[] =
+{
+    { "frame_draw_byte",                    benchmark_byte,                 200, 100, 20,         false },
+    { "frame_draw_char &font24",             benchmark_char,                 40,  100, 48,         false },
+    { "frame_draw_rotated_char &font12",     benchmark_rotated_char,         40,  100, 7,          false },
+    { "frame_draw_rotated_char &font16",     benchmark_rotated_char_bitwise, 40,  100, 11,         false },
+    { "frame_draw_giant_char",              benchmark_giant_char,           7,   100, 85,         false },
+    { "frame_draw_image 120x103",           benchmark_image,                6,   100, 103,        false },
+    { "frame_draw_line horizontal",         benchmark_line_horizontal,      40,  100, 40,         false },
+    { "frame_draw_line vertical",           benchmark_line_vertical,        40,  100, 100,        false },
+    { "frame_draw_line 1px",                benchmark_line_1,               20,  100, 101,        false },
+    { "frame_draw_line 2px",                benchmark_line_2,               20,  100, 102,        false },
+    { "frame_draw_line 3px",                benchmark_line_3,               20,  99,  103,        false },
+    { "frame_draw_filled_triangle",         benchmark_triangle,             20,  100, 61,         false },
+    { "frame_draw_circle",                  benchmark_circle,               20,  105, 31,         false },
+    { "frame_draw_graph",                   benchmark_graph,                1,   0,   EPD_HEIGHT, false },
+    { "frame_draw_default byte at a time",  frame_draw_default,             1,   0,   EPD_HEIGHT, true },
+    { "frame_draw_default",                 frame_draw_default,             1,   0,   EPD_HEIGHT, false },
+    { "frame_render_default",               benchmark_render_default,       1,   0,   EPD_HEIGHT, false },
+};
+
+/* Best cycles for drawing into every band the benchmark reaches, draw can be NULL to time clearing them */
+static uint32_t benchmark_bands(const frame_benchmark_t *benchmark, void (*draw)(void), uint8_t *buffer)
+{
+    const int first = (benchmark->top / EPD_BAND_HEIGHT) * EPD_BAND_HEIGHT,
+              end = benchmark->top + benchmark->height;
+    uint32_t best = UINT32_MAX;
+
+    for (int run = 0; run < BENCHMARK_RUNS; run++)
+    {
+        uint32_t start = esp_cpu_get_cycle_count();
+        for (band_top = first; band_top < end && band_top < EPD_HEIGHT; band_top += EPD_BAND_HEIGHT)
+        {
+            memset(buffer, 0x00, EPD_BAND_SIZE);
+            if (draw != NULL)
+            {
+                draw();
+            }
+        }
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        best = (cycles < best) ? cycles : best;
+    }
+    return best;
+}
+
+/* Pixels set by one run, drawn again as counting them while timing would be counted too */
+static uint32_t benchmark_pixels(const frame_benchmark_t *benchmark, uint8_t *buffer)
+{
+    const int first = (benchmark->top / EPD_BAND_HEIGHT) * EPD_BAND_HEIGHT,
+              end = benchmark->top + benchmark->height;
+    uint32_t pixels = 0;
+
+    for (band_top = first; band_top < end && band_top < EPD_HEIGHT; band_top += EPD_BAND_HEIGHT)
+    {
+        memset(buffer, 0x00, EPD_BAND_SIZE);
+        benchmark->draw();
+        for (int i = 0; i < EPD_BAND_SIZE; i++)
+        {
+            pixels += __builtin_popcount(buffer[i]);
+        }
+    }
+    return pixels;
+}
+
+esp_err_t frame_benchmark(FILE *results)
+{
+    uint8_t *buffer = malloc(EPD_BAND_SIZE);
+    if (buffer == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    frame_record_default(); // Replayed by frame_render_default()
+    band = (uint8_t (*)[EPD_BYTE_WIDTH])buffer;
+
+    fprintf(results, "benchmark,name,calls,cycles,pixels,cycles_per_call,cycles_per_pixel\n");
+    for (size_t i = 0; i < (sizeof(benchmarks) / sizeof(benchmarks[0])); i++)
+    {
+        const frame_benchmark_t *benchmark = &benchmarks[i];
+        benchmark_bytewise = benchmark->bytewise;
+        uint32_t clear = benchmark_bands(benchmark, NULL, buffer),
+                 cycles = benchmark_bands(benchmark, benchmark->draw, buffer),
+                 pixels = benchmark_pixels(benchmark, buffer);
+        cycles = (cycles > clear) ? (cycles - clear) : 0;
+        benchmark_bytewise = false;
+
+        ESP_LOGI("benchmark", "%s: %lu cycles per call, %.1f per pixel, best of %d", benchmark->name,
+                (unsigned long)(cycles / benchmark->calls), (pixels > 0) ? ((float)cycles / pixels) : 0.0f,
+                BENCHMARK_RUNS);
+        /* Lines start with "benchmark," so they can be picked out of a serial capture */
+        fprintf(results, "benchmark,%s,%d,%lu,%lu,%lu,%.2f\n", benchmark->name, benchmark->calls,
+                (unsigned long)cycles, (unsigned long)pixels, (unsigned long)(cycles / benchmark->calls),
+                (pixels > 0) ? ((float)cycles / pixels) : 0.0f);
+    }
+    fflush(results);
+    band = NULL;
+    band_top = 0;
+    free(buffer);
+    return ESP_OK;
+}
+#endif
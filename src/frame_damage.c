@@ -0,0 +1,119 @@
+#include <string.h>
+#include "display.h"
+#include "frame_damage.h"
+
+static int rect_right(const epd_rect_t *rect)  { return rect->x + rect->width; }
+static int rect_bottom(const epd_rect_t *rect) { return rect->y + rect->height; }
+
+static bool rect_near(const epd_rect_t *a, const epd_rect_t *b)
+{
+    return a->x <= (rect_right(b) + FRAME_DAMAGE_MERGE_SLACK) && b->x <= (rect_right(a) + FRAME_DAMAGE_MERGE_SLACK)
+        && a->y <= (rect_bottom(b) + FRAME_DAMAGE_MERGE_SLACK) && b->y <= (rect_bottom(a) + FRAME_DAMAGE_MERGE_SLACK);
+}
+
+static epd_rect_t rect_union(const epd_rect_t *a, const epd_rect_t *b)
+{
+    int x = (a->x < b->x) ? a->x : b->x,
+        y = (a->y < b->y) ? a->y : b->y,
+        right = (rect_right(a) > rect_right(b)) ? rect_right(a) : rect_right(b),
+        bottom = (rect_bottom(a) > rect_bottom(b)) ? rect_bottom(a) : rect_bottom(b);
+    return (epd_rect_t){ .x = x, .y = y, .width = right - x, .height = bottom - y };
+}
+
+static uint32_t rect_area(const epd_rect_t *rect)
+{
+    return (uint32_t)rect->width * rect->height;
+}
+
+static void damage_remove(frame_damage_t *damage, int index)
+{
+    damage->regions[index] = damage->regions[--damage->count];
+}
+
+void frame_damage_reset(frame_damage_t *damage)
+{
+    memset(damage, 0, sizeof(*damage));
+}
+
+void frame_damage_add(frame_damage_t *damage, int x, int y, int width, int height)
+{
+    /* Clip to the screen and widen to whole bytes, which is what partial windows address */
+    int right = x + width,
+        bottom = y + height;
+    x = (x < 0) ? 0 : x;
+    y = (y < 0) ? 0 : y;
+    right = (right > EPD_WIDTH) ? EPD_WIDTH : right;
+    bottom = (bottom > EPD_HEIGHT) ? EPD_HEIGHT : bottom;
+    if (right <= x || bottom <= y)
+    {
+        return;
+    }
+    x -= x % BITS_PER_BYTE;
+    right += (BITS_PER_BYTE - (right % BITS_PER_BYTE)) % BITS_PER_BYTE;
+    epd_rect_t box = { .x = x, .y = y, .width = right - x, .height = bottom - y };
+
+    /* Absorb every region the box touches, growing it as it goes, so merged regions never overlap */
+    for (int i = 0; i < damage->count; )
+    {
+        if (rect_near(&box, &damage->regions[i]))
+        {
+            box = rect_union(&box, &damage->regions[i]);
+            damage_remove(damage, i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    if (damage->count < FRAME_DAMAGE_MAX_REGIONS)
+    {
+        damage->regions[damage->count++] = box;
+        return;
+    }
+
+    /* Out of regions, fold the box into whichever one grows the least */
+    int best = 0;
+    uint32_t best_growth = UINT32_MAX;
+    for (int i = 0; i < damage->count; i++)
+    {
+        epd_rect_t merged = rect_union(&box, &damage->regions[i]);
+        uint32_t growth = rect_area(&merged) - rect_area(&damage->regions[i]);
+        if (growth < best_growth)
+        {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    damage->regions[best] = rect_union(&box, &damage->regions[best]);
+}
+
+bool frame_damage_intersects(const frame_damage_t *damage, int y, int height)
+{
+    for (int i = 0; i < damage->count; i++)
+    {
+        if (damage->regions[i].y < (y + height) && y < rect_bottom(&damage->regions[i]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t frame_damage_area(const frame_damage_t *damage)
+{
+    uint32_t area = 0;
+    for (int i = 0; i < damage->count; i++)
+    {
+        area += rect_area(&damage->regions[i]);
+    }
+    return area;
+}
+
+epd_rect_t frame_damage_bounds(const frame_damage_t *damage)
+{
+    epd_rect_t bounds = {0};
+    for (int i = 0; i < damage->count; i++)
+    {
+        bounds = (i == 0) ? damage->regions[i] : rect_union(&bounds, &damage->regions[i]);
+    }
+    return bounds;
+}
@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "display.h"
+#include "frame_diff.h"
+
+/* The frame is split into blocks of BLOCK_ROWS rows by BLOCK_BYTES bytes and only a hash of each is kept,
+ * which fits in RTC memory whatever the frame holds. A block whose hash matches is taken to be unchanged,
+ * with FNV-1a a changed block is missed about once in 4 billion and stays stale until the next full refresh */
+#define BLOCK_ROWS      8
+#define BLOCK_BYTES     10
+#define BLOCKS_DOWN     (EPD_HEIGHT / BLOCK_ROWS)
+#define BLOCKS_ACROSS   (EPD_BYTE_WIDTH / BLOCK_BYTES)
+#define BLOCKS_PER_BAND (EPD_BAND_HEIGHT / BLOCK_ROWS)
+#define HASH_SEED       2166136261u
+#define HASH_PRIME      16777619u
+
+static RTC_FAST_ATTR uint32_t previous[BLOCKS_DOWN][BLOCKS_ACROSS];
+static RTC_FAST_ATTR bool previous_valid = false;
+
+/* Prepared by frame_diff_compute() and moved into RTC memory by frame_diff_commit() */
+static uint32_t pending[BLOCKS_DOWN][BLOCKS_ACROSS];
+static bool pending_valid = false;
+
+/* Regions something else has drawn into since the frame was stored, see frame_diff_drawn_over() */
+static frame_damage_t drawn_over;
+
+static uint32_t block_hash(const uint8_t *band, int block_row, int block)
+{
+    uint32_t hash = HASH_SEED;
+    for (int row = 0; row < BLOCK_ROWS; row++)
+    {
+        const uint8_t *bytes = &band[(((block_row * BLOCK_ROWS) + row) * EPD_BYTE_WIDTH) + (block * BLOCK_BYTES)];
+        for (int i = 0; i < BLOCK_BYTES; i++)
+        {
+            hash = (hash ^ bytes[i]) * HASH_PRIME;
+        }
+    }
+    return hash;
+}
+
+/* Extends the rectangle touching the rows above, or starts a new one. Once out of rectangles
+ * the last one is stretched down to cover the rows, as a few extra pixels beat an extra window */
+static void diff_add_rows(frame_diff_t *diff, int y, int height, int left_byte, int right_byte)
+{
+    uint16_t x = left_byte * BITS_PER_BYTE,
+             right = (right_byte + 1) * BITS_PER_BYTE;
+    epd_rect_t *rect = (diff->count > 0) ? &diff->rects[diff->count - 1] : NULL;
+
+    if (rect == NULL || ((rect->y + rect->height) != y && diff->count < FRAME_DIFF_MAX_RECTS))
+    {
+        diff->rects[diff->count++] = (epd_rect_t){ .x = x, .y = y, .width = right - x, .height = height };
+        return;
+    }
+    uint16_t new_right = ((rect->x + rect->width) > right) ? (rect->x + rect->width) : right;
+    rect->x = (rect->x < x) ? rect->x : x;
+    rect->width = new_right - rect->x;
+    rect->height = y + height - rect->y;
+}
+
+/* With nothing to compare against, the regions known to have changed are sent as they are. Past the last
+ * rectangle they're folded into it, like diff_add_rows() does with rows */
+static void diff_add_regions(frame_diff_t *diff, const frame_damage_t *changed)
+{
+    for (int i = 0; i < changed->count; i++)
+    {
+        const epd_rect_t *region = &changed->regions[i];
+        if (diff->count < FRAME_DIFF_MAX_RECTS)
+        {
+            diff->rects[diff->count++] = *region;
+            continue;
+        }
+        epd_rect_t *rect = &diff->rects[diff->count - 1];
+        uint16_t right = ((rect->x + rect->width) > (region->x + region->width)) ?
+                    (rect->x + rect->width) : (region->x + region->width),
+                 bottom = ((rect->y + rect->height) > (region->y + region->height)) ?
+                    (rect->y + rect->height) : (region->y + region->height);
+        rect->x = (rect->x < region->x) ? rect->x : region->x;
+        rect->y = (rect->y < region->y) ? rect->y : region->y;
+        rect->width = right - rect->x;
+        rect->height = bottom - rect->y;
+    }
+}
+
+esp_err_t frame_diff_compute(epd_band_renderer_t render, const frame_damage_t *changed, frame_diff_t *diff)
+{
+    uint8_t *band = malloc(EPD_BAND_SIZE);
+    if (band == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const bool compare = previous_valid;
+    int reused = 0;
+
+    memset(diff, 0, sizeof(*diff));
+    diff->full = (!compare && changed == NULL);
+    for (int top = 0; top < EPD_HEIGHT; top += EPD_BAND_HEIGHT)
+    {
+        const int first_block_row = top / BLOCK_ROWS;
+        if (compare && changed != NULL && !frame_damage_intersects(changed, top, EPD_BAND_HEIGHT))
+        {
+            /* Nothing drawn here has changed, the band is still the previous frame's */
+            memcpy(pending[first_block_row], previous[first_block_row], sizeof(previous[0]) * BLOCKS_PER_BAND);
+            reused++;
+            continue;
+        }
+        memset(band, 0x00, EPD_BAND_SIZE);
+        render(band, top);
+        for (int block_row = 0; block_row < BLOCKS_PER_BAND; block_row++)
+        {
+            uint32_t *hashes = pending[first_block_row + block_row];
+            int left = -1, right = -1;
+            for (int block = 0; block < BLOCKS_ACROSS; block++)
+            {
+                hashes[block] = block_hash(band, block_row, block);
+                if (compare && hashes[block] != previous[first_block_row + block_row][block])
+                {
+                    left = (left < 0) ? block : left;
+                    right = block;
+                }
+            }
+            if (left >= 0)
+            {
+                diff_add_rows(diff, top + (block_row * BLOCK_ROWS), BLOCK_ROWS, left * BLOCK_BYTES,
+                        ((right + 1) * BLOCK_BYTES) - 1);
+            }
+        }
+    }
+    free(band);
+    pending_valid = true;
+    ESP_LOGI("diff", "Frame hashed in %d blocks, %d bands reused from the previous frame",
+            BLOCKS_DOWN * BLOCKS_ACROSS, reused);
+
+    if (!compare && changed != NULL)
+    {
+        diff_add_regions(diff, changed);
+    }
+    if (!diff->full)
+    {
+        diff_add_regions(diff, &drawn_over); // Whatever the hashes say, the display shows something else there
+    }
+    frame_damage_reset(&drawn_over);
+    for (int i = 0; i < diff->count; i++)
+    {
+        diff->dirty_pixels += diff->rects[i].width * diff->rects[i].height;
+    }
+    if (diff->dirty_pixels > ((EPD_WIDTH * EPD_HEIGHT) / 100) * FRAME_DIFF_FULL_PERCENT)
+    {
+        diff->full = true;
+    }
+    ESP_LOGI("diff", "%d dirty rects covering %lu pixels, %s", diff->count, (unsigned long)diff->dirty_pixels,
+            diff->full ? "full refresh" : (diff->count == 0 ? "unchanged" : "partial refresh"));
+    return ESP_OK;
+}
+
+void frame_diff_drawn_over(int x, int y, int width, int height)
+{
+    frame_damage_add(&drawn_over, x, y, width, height);
+}
+
+void frame_diff_commit(void)
+{
+    if (!pending_valid)
+    {
+        return;
+    }
+    memcpy(previous, pending, sizeof(previous));
+    previous_valid = true;
+    pending_valid = false;
+}
+
+void frame_diff_invalidate(void)
+{
+    previous_valid = false;
+    pending_valid = false;
+}
@@ -0,0 +1,50 @@
+#include <string.h>
+#include "display.h"
+#include "frame_list.h"
+
+void frame_list_reset(frame_list_t *list)
+{
+    list->count = 0;
+    list->overflow = false;
+    list->text_size = 0;
+}
+
+void frame_list_add(frame_list_t *list, const frame_op_t *op, int y, int height)
+{
+    /* Operations entirely off screen are dropped, the rest keep their rows clipped to the screen */
+    int bottom = y + height;
+    y = (y < 0) ? 0 : y;
+    bottom = (bottom > EPD_HEIGHT) ? EPD_HEIGHT : bottom;
+    if (bottom <= y)
+    {
+        return;
+    }
+    if (list->count == FRAME_LIST_MAX_OPS)
+    {
+        list->overflow = true;
+        return;
+    }
+    frame_op_t *dst = &list->ops[list->count++];
+    *dst = *op;
+    dst->top = y;
+    dst->bottom = bottom;
+}
+
+uint16_t frame_list_add_text(frame_list_t *list, const char *str)
+{
+    size_t length = strlen(str) + 1;
+    if ((list->text_size + length) > FRAME_LIST_TEXT_SIZE)
+    {
+        list->overflow = true;
+        return 0;
+    }
+    uint16_t offset = list->text_size;
+    memcpy(&list->text[offset], str, length);
+    list->text_size += length;
+    return offset;
+}
+
+bool frame_list_reaches(const frame_op_t *op, int y, int height)
+{
+    return op->top < (y + height) && y < op->bottom;
+}
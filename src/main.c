@@ -1,8 +1,8 @@
 #include <time.h>
-#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "soc/adc_channel.h"
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
@@ -19,8 +19,12 @@
 #include "soc/rtc.h"
 #include "ulp_riscv.h"
 #include "display.h"
-#include "fonts.h"
-#include "icons.h"
+#include "epd.h"
+#include "epd_spi.h"
+#include "frame_diff.h"
+#include "frame.h"
+#include "refresh_policy.h"
+#include "fixed_math.h"
 #include "ulp_main.h" // Generated by CMake, extern declarations for ULP variables
 #include "secret.h" // Not included in repo
 /* ^ Defines:
@@ -31,12 +35,6 @@
  * - API_KEY
  */
 
-/* Following functions are placed in IRAM as they are frequently called:
- * - spi_write_byte: called by all SPI write functions
- * - spi_write_command: called for every command sent to the display
- * - spi_write_data: called for every byte of data sent to the display
- * - frame_draw_byte: called by all frame drawing functions */
-
 // TODO: use espidf heap tracing to check for memory leaks
 
 /* Main event group */
@@ -66,7 +64,7 @@ static uint64_t deferred_uS = 0;
 
 /* Wall clock time */
 static time_t now;
-static struct tm timeinfo;
+struct tm timeinfo;
 #define UPDATE_TIME do { time(&now); localtime_r(&now, &timeinfo); } while(0)
 
 /* Wifi definitions and variables */
@@ -78,7 +76,7 @@ static esp_netif_t *wifi_if = NULL;
 #define MAX_RETRY_NUM      5
 
 /* Battery definitions and variables */
-static uint8_t battery_percentage = 0;
+uint8_t battery_percentage = 0;
 #define BATTERY_THRESHOLD 10 // Percentage at which the battery is considered critically low
 
 /* Root server certificate for api.openweathermap.org embedded by CMake */
@@ -89,752 +87,144 @@ extern const uint8_t server_cert_pem_end[]   asm("_binary_openweather_pem_end");
 extern const uint8_t bin_start[] asm("_binary_ulp_main_bin_start");
 extern const uint8_t bin_end[]   asm("_binary_ulp_main_bin_end");
 
-/* Weather id definitions */
-enum
-{
-    THUNDERSTORM_START = 200,
-    THUNDERSTORM_END   = 232,
-    DRIZZLE_START      = 300,
-    DRIZZLE_END        = 321,
-    RAIN_START         = 500,
-    RAIN_END           = 531,
-    SNOW_START         = 600,
-    SNOW_END           = 622,
-    ATMOSPHERE_START   = 701,
-    ATMOSPHERE_END     = 781,
-    CLEAR_SKY          = 800,
-    CLOUDS_START       = 801,
-    CLOUDS_END         = 804
-};
-
-static RTC_FAST_ATTR struct weather_today
-{
-    uint16_t id;
-    char description[32];
-    float current_temp;
-    float feels_like_temp;
-    float high_temp;
-    float low_temp;
-    float wind_speed;
-    uint16_t wind_direction_degrees; // Degrees from north that the wind is coming from
-    float cloudiness; // % of sky covered by clouds
-} weather;
-
-#define FORECAST_HOURS 12
-static RTC_FAST_ATTR struct hourly_forecast
-{
-    float temp;
-    float precipitation_chance;
-    char time[6]; // "%Ip" Datetime string
-} hourly_forecast[FORECAST_HOURS];
+/* Refresh policy state is kept in ULP memory so the ULP's clock updates count towards it as well */
+#define refresh_policy (*(refresh_policy_t *)&ulp_refresh_policy)
+static const char *const refresh_mode_names[REFRESH_MODES] = {"partial", "fast", "full"};
 
-#define FORECAST_DAYS 8 // First item is current day, next 7 are forecast for next 7 days
-static RTC_FAST_ATTR struct weather_forecast
-{
-    uint16_t id;
-    float high_temp;
-    float low_temp;
-    float precipitation_chance;
-    char day[10]; // "%A" Datetime string
-} forecast[FORECAST_DAYS];
+/* Weather the frame is drawn from, fetched every few hours and kept across deep sleep */
+RTC_FAST_ATTR struct weather_today weather;
+RTC_FAST_ATTR struct hourly_forecast hourly_forecast[FORECAST_HOURS];
+RTC_FAST_ATTR struct weather_forecast forecast[FORECAST_DAYS];
 
-static uint8_t frame[EPD_HEIGHT][EPD_BYTE_WIDTH];
+/* Bands are consumed in order by the diff and by the display, which then spend a while compressing,
+ * comparing or sending each one. So while the caller works on a band, the one after it is rendered on
+ * core 1 into a buffer of its own and copied out when it's asked for. Windows of a partial update can
+ * jump ahead, a band that wasn't rendered ahead is rendered directly as before */
+static TaskHandle_t render_task = NULL;
+static SemaphoreHandle_t render_done = NULL;
+static uint8_t *render_ahead = NULL;
+static int render_ahead_top = -1; // Band being rendered into render_ahead, -1 when the task is idle
 
-// TODO: Switch to hardware version of spi
-static void IRAM_ATTR spi_write_byte(uint8_t byte)
+static void task_render_ahead(void *pvParameters)
 {
-    for (int i = 0; i < BITS_PER_BYTE; i++)
+    while (true)
     {
-        rtc_gpio_set_level(MOSI_PIN, (byte & 0x80) ? HIGH : LOW); // 0x80 = 10000000 BITMASK
-        byte <<= 1;
-        rtc_gpio_set_level(SCK_PIN, HIGH);
-        rtc_gpio_set_level(SCK_PIN, LOW);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        memset(render_ahead, 0x00, EPD_BAND_SIZE);
+        frame_render_default(render_ahead, render_ahead_top);
+        xSemaphoreGive(render_done);
     }
 }
 
-static void IRAM_ATTR spi_write_command(uint8_t command)
-{
-    rtc_gpio_set_level(DC_PIN, LOW); // Command mode
-    rtc_gpio_set_level(CS_PIN, LOW);
-    spi_write_byte(command);
-    rtc_gpio_set_level(CS_PIN, HIGH);
-}
-
-static void IRAM_ATTR spi_write_data(uint8_t data)
-{
-    rtc_gpio_set_level(DC_PIN, HIGH); // Data mode
-    rtc_gpio_set_level(CS_PIN, LOW);
-    spi_write_byte(data);
-    rtc_gpio_set_level(CS_PIN, HIGH);
-}
-
-static void epd_reset()
-{
-    rtc_gpio_set_level(RST_PIN, HIGH);
-    vTaskDelay(20 / portTICK_PERIOD_MS);
-    rtc_gpio_set_level(RST_PIN, LOW); // Low is active
-    vTaskDelay(20 / portTICK_PERIOD_MS);
-    rtc_gpio_set_level(RST_PIN, HIGH);
-}
-
-static void epd_wait_until_idle()
-{
-    while (rtc_gpio_get_level(BUSY_PIN) == LOW)
-    {
-        ESP_LOGI("epd", "Display is busy...");
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
-    ESP_LOGI("epd", "Display is released");
-}
-
-static void epd_init()
-{
-    /* Datasheet at https://files.waveshare.com/upload/6/60/7.5inch_e-Paper_V2_Specification.pdf
-     * was used as a reference for the initialization sequence and commands */
-    epd_reset();
-
-    /* Default from datasheet unless otherwise specified */
-    spi_write_command(BOOSTER_SOFT_START);
-    spi_write_data(0x17);
-    spi_write_data(0x17);
-    spi_write_data(0x27);
-    spi_write_data(0x17);
-
-    spi_write_command(POWER_SETTING);
-    spi_write_data(0x07);
-    spi_write_data(0x17);
-    spi_write_data(0x3f);
-    spi_write_data(0x3f);
-
-    spi_write_command(POWER_ON);
-    epd_wait_until_idle();
-
-    spi_write_command(PANEL_SETTING);
-    spi_write_data(0x1f);
-
-    spi_write_command(RESOLUTION_SETTING);
-    spi_write_data(0x03);
-    spi_write_data(0x20);
-    spi_write_data(0x01);
-    spi_write_data(0xe0);
-
-    spi_write_command(DUAL_SPI);
-    spi_write_data(0x00);
-
-    spi_write_command(TCON_SETTING);
-    spi_write_data(0x22);
-
-    /* Altered from default to transfer data from NEW to OLD automatically */
-    spi_write_command(VCOM_DATA_INTERVAL);
-    spi_write_data(0x18);
-    spi_write_data(0x07);
-
-    /* Enable fast refresh */
-    spi_write_command(CASCADE_SETTING);
-    spi_write_data(0x02);
-    spi_write_command(FORCE_TEMPERATURE);
-    spi_write_data(0x5a);
-
-    ESP_LOGI("epd", "Initialization complete");
-}
-
-static void epd_clear()
+/* Waits for the band being rendered ahead, if any */
+static void frame_render_join()
 {
-    epd_wait_until_idle();
-    spi_write_command(TRANSFER_DATA_2);
-    for (size_t i = 0; i < (EPD_HEIGHT * EPD_BYTE_WIDTH); i++)
+    if (render_ahead_top >= 0)
     {
-        spi_write_data(0x00);
+        xSemaphoreTake(render_done, portMAX_DELAY);
     }
-    spi_write_command(DISPLAY_REFRESH);
-    epd_wait_until_idle();
 }
 
-static void epd_write_frame()
+static void frame_render_parallel(uint8_t *buffer, int top)
 {
-    epd_wait_until_idle();
-    spi_write_command(TRANSFER_DATA_2);
-    rtc_gpio_set_level(CS_PIN, HIGH);
-    for (size_t i = 0; i < EPD_HEIGHT; i++)
-    {
-        for (size_t j = 0; j < EPD_BYTE_WIDTH; j++)
-        {
-            spi_write_data(frame[i][j]);
-        }
-    }
-    spi_write_command(DISPLAY_REFRESH);
-    epd_wait_until_idle();
-}
-
-static void epd_sleep()
-{
-    spi_write_command(POWER_OFF);
-    epd_wait_until_idle();
-}
-
-static void IRAM_ATTR frame_draw_byte(int x, int y, uint8_t byte)
-{
-    if (unlikely(x < 0 || x >= EPD_WIDTH || y < 0 || y >= EPD_HEIGHT))
-    {
-        ESP_LOGE("frame", "Byte position out of bounds: x=%d, y=%d", x, y);
-        return;
-    }
-    /* Shift the byte to align with the correct bits in the frame buffer, then OR it with the existing byte
-     * to preserve any pixels that have already been drawn in that byte. */
-    frame[y][x / BITS_PER_BYTE] |= byte >> (x % BITS_PER_BYTE);
-    /* If the byte being drawn isn't aligned to a byte boundary, then
-     * the byte next to it also needs to be updated with the remaining bits. */
-    if ((x % BITS_PER_BYTE) != 0 && (x / BITS_PER_BYTE + 1) < EPD_BYTE_WIDTH)
-    {
-        frame[y][x / BITS_PER_BYTE + 1] |= byte << (BITS_PER_BYTE - (x % BITS_PER_BYTE));
-    }
-}
-
-static void frame_draw_char(int x, int y, font_t font, char c)
-{
-    const uint8_t bytes_per_char = (font.width / BITS_PER_BYTE) + (font.width % BITS_PER_BYTE != 0);
-
-    /* Subtract the first character in the font from the character to get the index,
-     * then multiply by the number of bytes per character to get the offset in the font data array */
-    const size_t offset = (c - ' ') * font.height * bytes_per_char;
-    const uint8_t *char_start = font.table + offset;
-
-    for (int i = 0; i < font.height; i++)
-    {
-        for (int j = 0; j < bytes_per_char; j++)
-        {
-            frame_draw_byte((x + (j * BITS_PER_BYTE)), (y + i), char_start[i * bytes_per_char + j]);
-        }
-    }
-}
-
-static void frame_draw_rotated_char(int x, int y, font_t font, char c)
-{
-    const uint8_t bytes_per_char = (font.width / BITS_PER_BYTE) + (font.width % BITS_PER_BYTE != 0);
-    const size_t offset = (c - ' ') * font.height * bytes_per_char;
-    const uint8_t *char_start = font.table + offset;
-    const uint8_t bytes_per_row_rot = (font.height / BITS_PER_BYTE) + (font.height % BITS_PER_BYTE != 0);
-
-    for (int i = 0; i < font.width; i++)
+    const bool ahead = (render_ahead_top == top);
+    frame_render_join();
+    render_ahead_top = -1;
+    if (ahead)
     {
-        for (int j = 0; j < bytes_per_row_rot; j++)
-        {
-            uint8_t rotated_byte = 0;
-            for (int k = 0; k < BITS_PER_BYTE; k++)
-            {
-                int new_col = (j * BITS_PER_BYTE) + k,
-                    old_row = (font.height - 1) - new_col,
-                    old_col = i;
-                if (new_col >= font.height) { break; }
-
-                const uint8_t src_byte = char_start[old_row * bytes_per_char + old_col / BITS_PER_BYTE];
-                const uint8_t bit = (src_byte >> (BITS_PER_BYTE - 1 - (old_col % BITS_PER_BYTE))) & 1u;
-                rotated_byte |= bit << (BITS_PER_BYTE - 1 - k);
-            }
-            frame_draw_byte((x + (j * BITS_PER_BYTE)), (y + i), rotated_byte);
-        }
-    }
-}
-
-static void frame_draw_giant_char(int x, int y, uint32_t offset)
-{
-    const uint8_t bytes_per_char = (font60.width / BITS_PER_BYTE) + (font60.width % BITS_PER_BYTE != 0);
-    const uint8_t *char_start = font60.table + offset;
-
-    for (int i = 0; i < font60.height; i++)
-    {
-        for (int j = 0; j < bytes_per_char; j++)
-        {
-            frame_draw_byte((x + (j * BITS_PER_BYTE)), (y + i), char_start[i * bytes_per_char + j]);
-        }
-    }
-}
-
-static void frame_draw_rotated_string(int x, int y, font_t font, const char *str)
-{
-    while (str[0] != '\0')
-    {
-        /* Slightly cursed code to make periods look better */
-        y -= (str[0] == '.' && font.width < 20) ? ((font.width / 2) - 1) : 0;
-        frame_draw_rotated_char(x, y, font, *str);
-        y += (str[0] != '.') ? font.width : ((font.width / 2) + 2);
-        str++;
-    }
-}
-
-static void frame_draw_string(int x, int y, font_t font, const char *str)
-{
-    while (str[0] != '\0')
-    {
-        /* Slightly cursed code to make periods look better */
-        x -= (str[0] == '.' && font.width < 20) ? ((font.width / 2) - 1) : 0;
-        frame_draw_char(x, y, font, *str);
-        x += (str[0] != '.') ? font.width : ((font.width / 2) + 2);
-        str++;
-    }
-}
-
-static void frame_draw_image(int x, int y, icon_t icon)
-{
-    for (int i = 0; i < icon.height; i++)
-    {
-        for (int j = 0; j < (icon.width / BITS_PER_BYTE); j++)
-        {
-            uint8_t byte = icon.data[i * (icon.width / BITS_PER_BYTE) + j];
-            frame_draw_byte(x + (j * BITS_PER_BYTE), y + i, byte);
-        }
-    }
-}
-
-/* Used to draw degree symbol, unecessary, but I wanted to implement the midpoint circle algorithm */
-static void frame_draw_circle(int center_x, int center_y, int radius)
-{
-    int x = radius,
-        y = 0,
-        decision_over_2 = 1 - x; // Decision criterion divided by 2 evaluated at x=r, y=0
-
-    while (y <= x)
-    {
-        frame_draw_byte(center_x + x, center_y + y, 0xc0);
-        frame_draw_byte(center_x + y, center_y + x, 0xc0);
-        frame_draw_byte(center_x - x, center_y + y, 0xc0);
-        frame_draw_byte(center_x - y, center_y + x, 0xc0);
-        frame_draw_byte(center_x - x, center_y - y, 0xc0);
-        frame_draw_byte(center_x - y, center_y - x, 0xc0);
-        frame_draw_byte(center_x + x, center_y - y, 0xc0);
-        frame_draw_byte(center_x + y, center_y - x, 0xc0);
-        y++;
-        if (decision_over_2 <= 0) { decision_over_2 += 2 * y + 1; }
-        else                      { x--; decision_over_2 += 2 * (y - x) + 1; }
-    }
-}
-
-static void frame_draw_line(int x0, int y0, int x1, int y1, int thickness)
-{
-    int dx  = abs(x1 - x0),
-        sx  = x0 < x1 ? 1 : -1,
-        dy  = -abs(y1 - y0),
-        sy  = y0 < y1 ? 1 : -1,
-        err = dx + dy,
-        e2;
-    bool straight_line = (dx == 0 || dy == 0);
-
-    /* For straight lines simply iterate over x/y to draw them */
-    if (straight_line)
-    {
-        if (dy == 0)
-        {
-            if (thickness == 1)
-            {
-                while (x0 != x1)
-                {
-                    frame_draw_byte(x0, y0, 0x80);
-                    x0 += sx;
-                }
-            } else {
-                for (int i = 0; i < thickness; i++)
-                {
-                    /* Recursively draw lines on either side of the original line to create thickness,
-                     * alternating sides to keep it centered */
-                    int8_t flip = (i % 2 == 0) ? ((i / 2) * - 1) : ((i + 1) / 2);
-                    frame_draw_line(x0, y0 + flip, x1, y1 + flip, 1);
-                }
-            }
-        } else {
-            while (y0 != y1)
-            {
-                uint8_t byte = (uint8_t)(0xFF00 >> thickness);
-                frame_draw_byte(x0, y0, byte);
-                y0 += sy;
-            }
-        }
-    }
-    else if (thickness > 1)
-    {
-        for (int i = 0; i < thickness; i++)
-        {
-            int8_t flip = (i % 2 == 0) ? ((i / 2) * - 1) : ((i + 1) / 2);
-            frame_draw_line(x0, y0 + flip, x1, y1 + flip, 1);
-        }
-
+        memcpy(buffer, render_ahead, EPD_BAND_SIZE);
     } else {
-        /* Bresenham Line Drawing Algorithm for non straight lines */
-        while (true)
-        {
-            frame_draw_byte(x0, y0, 0xc0);
-            if (x0 == x1 && y0 == y1) break;
-            e2 = 2 * err;
-            if (e2 >= dy)
-            {
-                err += dy;
-                x0 += sx;
-            }
-            if (e2 <= dx)
-            {
-                err += dx;
-                y0 += sy;
-            }
-        }
+        frame_render_default(buffer, top);
     }
-}
-
-/* Draws a rectangle with vertical lines */
-static void frame_draw_dotted_rectangle(int left, int top, int right, int bottom, int thickness)
-{
-    frame_draw_line(left, top, left, bottom, thickness);
-    frame_draw_line(right, top, right, bottom, thickness);
-    frame_draw_line(left, top, right, top, thickness);
-    frame_draw_line(left, bottom, right, bottom, thickness);
-    for (int i = left; i < right; i += 3)
+    if ((top + EPD_BAND_HEIGHT) < EPD_HEIGHT)
     {
-        frame_draw_line(i, top, i, bottom, thickness);
+        render_ahead_top = top + EPD_BAND_HEIGHT;
+        xTaskNotifyGive(render_task);
     }
 }
 
-static void frame_draw_filled_triangle(int x0, int y0, int x1, int y1, int x2, int y2)
+/* The ULP used to do a full refresh every 5 clock updates, logged alongside so the savings are visible */
+static void refresh_policy_log()
 {
-    /* Sort the vertices by y-coordinate ascending (y0 <= y1 <= y2) */
-    if (y0 > y1) { int t=x0; x0=x1; x1=t; t=y0; y0=y1; y1=t; }
-    if (y0 > y2) { int t=x0; x0=x2; x2=t; t=y0; y0=y2; y2=t; }
-    if (y1 > y2) { int t=x1; x1=x2; x2=t; t=y1; y1=y2; y2=t; }
-    int total_h = y2 - y0;
-
-    /* Scanline algorithm */
-    for (int y = y0; y <= y2; y++)
+    uint32_t total = 0;
+    for (int i = 0; i < REFRESH_MODES; i++)
     {
-        double xa = (x0 + (double)(x2 - x0) * (y - y0) / total_h),
-               xb;
-        if (y <= y1)
-        {
-            int seg = y1 - y0;
-            xb = (seg == 0) ? x0 : (x0 + (double)(x1 - x0) * (y - y0) / seg);
-        } else {
-            int seg = y2 - y1;
-            xb = (seg == 0) ? x1 : (x1 + (double)(x2 - x1) * (y - y1) / seg);
-        }
-        if (xa > xb) { double tmp = xa; xa = xb; xb = tmp; }
-        int ixa = (int)ceil(xa),
-            ixb = (int)floor(xb),
-            remaining = ixb - ixa + 1,
-            x = ixa;
-        while (remaining > 0)
-        {
-            int bits = (remaining > 8) ? 8 : remaining;
-            uint8_t mask = (uint8_t)(0xFF00u >> bits);
-            frame_draw_byte(x, y, mask);
-            x += bits;
-            remaining -= bits;
-        }
+        total += refresh_policy.counts[i];
     }
+    ESP_LOGI("refresh", "Since boot: %lu full, %lu fast, %lu partial refreshes (1 in 5 would have been %lu full)",
+            (unsigned long)refresh_policy.counts[REFRESH_FULL], (unsigned long)refresh_policy.counts[REFRESH_FAST],
+            (unsigned long)refresh_policy.counts[REFRESH_PARTIAL], (unsigned long)(total / 5));
 }
 
-static void frame_draw_arrow(int x, int y, uint16_t degrees, int length)
+static void rtc_gpio_set_low_all()
 {
-    /* Convert degrees to radians and adjust so 0 degrees is pointing up */
-    float radians = degrees * (M_PI / 180.0f);
-    /* Screen space unit vector in the direction of the wind */
-    double dx      = sin(radians),
-           dy      = -cos(radians),
-    /* Perpendicular vector for the arrowhead */
-           px      = dy,
-           py      = -dx,
-    /* Coordinates where the arrowhead is attached to the line */
-           base_cx = x + 0.50 * length * dx,
-           base_cy = y + 0.50 * length * dy;
-    /* Second set of coordinates for the line of the arrow */
-    int    edge_x  = (int)(x + length * dx),
-           edge_y  = (int)(y + length * dy),
-    /* Coordinates for the tip of the arrow */
-           tip_x   = (int)(x + 1 * length * dx),
-           tip_y   = (int)(y + 1 * length * dy),
-    /* Coordinates for two sides of the triangle for the arrowhead, using the perpendicular vector */
-           b1x     = (int)round(base_cx + 0.30 * length * px),
-           b1y     = (int)round(base_cy + 0.30 * length * py),
-           b2x     = (int)round(base_cx - 0.30 * length * px),
-           b2y     = (int)round(base_cy - 0.30 * length * py);
-    frame_draw_line(x, y, edge_x, edge_y, 2);
-    frame_draw_filled_triangle(tip_x, tip_y, b1x, b1y, b2x, b2y);
+    rtc_gpio_set_level(CS_PIN, LOW);
+    rtc_gpio_set_level(DC_PIN, LOW);
+    rtc_gpio_set_level(RST_PIN, LOW);
+    rtc_gpio_set_level(MOSI_PIN, LOW);
+    rtc_gpio_set_level(SCK_PIN, LOW);
 }
 
-static void frame_draw_compass(int x, int y, uint16_t degrees, int length)
-{
-    /* Draw a circle for the compass background */
-    frame_draw_circle(x, y, length);
-    /* Draw arrow in the direction of the wind */
-    frame_draw_arrow(x, y, degrees, length);
-    /* Draw N, E, S, W indicators */
-    frame_draw_char(x - (font16.width / 2), y - length - font16.height, font16, 'N');
-    frame_draw_char(x + length + 4, y - (font16.height / 2), font16, 'E');
-    frame_draw_char(x - (font16.width / 2) + 2, y + length + 2, font16, 'S');
-    frame_draw_char(x - length - font16.width - 2, y - (font16.height / 2), font16, 'W');
-}
+/* After a wakeup from deep sleep the ULP's timer is still running, and it can be part way through a minute
+ * when the main CPU starts. Keeps it away from the pins and the variables it shares with the main CPU until
+ * ulp_release(), waiting for a wakeup already under way to finish */
+#define ULP_HOLD_TIMEOUT_MS 15000 // A full refresh and the ULP's debug delay, with room to spare
+static bool ulp_held = false;
 
-static void frame_draw_time(int x, int y)
+static void ulp_hold()
 {
-    UPDATE_TIME;
-    uint16_t hour = ((timeinfo.tm_hour % 12) == 0) ? 12 : (timeinfo.tm_hour % 12),
-             minute = timeinfo.tm_min,
-             afternoon = (timeinfo.tm_hour >= 12) ? 0 : 1;
-    ESP_LOGI("time", "Current time: %02d:%02d %s", (hour == 0) ? 12 : hour, minute, afternoon ? "AM" : "PM");
-
-    uint8_t time[] =
-    {
-        (hour / 10) % 10,
-        hour % 10,
-        10, // ':' character
-        (minute / 10) % 10,
-        minute % 10,
-        afternoon ? 11 : 12,
-        13 // 'M' character
-    };
-
-    for (int i = 0; i < sizeof(time); i++)
+    ulp_main_cpu_active = 1;
+    ulp_riscv_timer_stop();
+    ulp_held = true;
+    for (int waited = 0; ulp_busy; waited += 10)
     {
-        switch (time[i])
+        if (waited >= ULP_HOLD_TIMEOUT_MS)
         {
-            case 0:  frame_draw_giant_char(x + (i * font60.width), y, ZERO); break;
-            case 1:  frame_draw_giant_char(x + (i * font60.width), y, ONE); break;
-            case 2:  frame_draw_giant_char(x + (i * font60.width), y, TWO); break;
-            case 3:  frame_draw_giant_char(x + (i * font60.width), y, THREE); break;
-            case 4:  frame_draw_giant_char(x + (i * font60.width), y, FOUR); break;
-            case 5:  frame_draw_giant_char(x + (i * font60.width), y, FIVE); break;
-            case 6:  frame_draw_giant_char(x + (i * font60.width), y, SIX); break;
-            case 7:  frame_draw_giant_char(x + (i * font60.width), y, SEVEN); break;
-            case 8:  frame_draw_giant_char(x + (i * font60.width), y, EIGHT); break;
-            case 9:  frame_draw_giant_char(x + (i * font60.width), y, NINE); break;
-            case 10: frame_draw_giant_char(x + (i * font60.width), y, COLON); break;
-            case 11: frame_draw_giant_char(x + (i * font60.width), y, LETTER_A); break;
-            case 12: frame_draw_giant_char(x + (i * font60.width), y, LETTER_P); break;
-            case 13: frame_draw_giant_char(x + (i * font60.width), y, LETTER_M); break;
+            ESP_LOGW("ulp", "Still busy after %d ms, halting it", waited);
+            ulp_riscv_halt(); // Starts again from the top on the next timer wakeup
+            ulp_busy = 0;
+            break;
         }
+        vTaskDelay(10 / portTICK_PERIOD_MS);
     }
 }
 
-static void frame_draw_icon(int x, int y, uint16_t weather_id, bool small_image)
+/* Time the ULP draws next, from timeinfo */
+static void ulp_set_time()
 {
-    UPDATE_TIME;
-    bool is_daytime = (timeinfo.tm_hour >= 6 && timeinfo.tm_hour < 18);
-    icon_t icon;
-
-    /* Weather condition codes documented at https://openweathermap.org/weather-conditions */
-    switch (weather_id)
-    {
-        case THUNDERSTORM_START ... THUNDERSTORM_END:
-            icon = small_image ? thunder_small : thunder; break;
-        case DRIZZLE_START ... DRIZZLE_END:
-            icon = small_image ? drizzle_small : drizzle; break;
-        case RAIN_START ... RAIN_END:
-            icon = small_image ? rain_small : rain; break;
-        case SNOW_START ... SNOW_END:
-            icon = small_image ? snow_small : snow; break;
-        case ATMOSPHERE_START ... ATMOSPHERE_END:
-            icon = small_image ? haze_small : haze; break;
-        case CLEAR_SKY:
-            icon = (small_image) ? sun_small : ((is_daytime) ? sun : moon); break;
-        case CLOUDS_START ... CLOUDS_END:
-            icon = small_image ? cloud_small : cloud; break;
-        default:
-            ESP_LOGE("icon", "Unknown weather id: %d, using default cloud icon", weather_id);
-            icon = small_image ? cloud_small : cloud; break;
-    }
-    frame_draw_image(x, y, icon);
+    ulp_hours = timeinfo.tm_hour % 12;
+    ulp_hours = (ulp_hours == 0) ? 12 : ulp_hours;
+    ulp_minutes = timeinfo.tm_min;
 }
 
-/* Draw graph of two sets of points with the same y-axes, used for the temperature and precipitation forecast graph
- * first series of points is drawn with a solid line and the second series is drawn with as dashed boxes */
-static void frame_draw_graph(int left, int top, int right, int bottom, float min_value, float max_value,
-        struct hourly_forecast hourly_forecast[], int num_points, int num_lines_y, const char *left_label_format,
-        const char *right_label_format)
+/* Hands the clock back to the ULP, once the pins are back on RTC GPIO */
+static void ulp_release()
 {
-    /* |_| shaped graph */
-    frame_draw_line(left, top, left, bottom + 1, 2);
-    frame_draw_line(left, bottom, right, bottom, 2);
-    frame_draw_line(right, top, right, bottom + 2, 2);
-
-    /* Y axis increases as you go down the screen */
-    int    graph_width       = abs(right - left),
-           graph_height      = abs(bottom - top),
-           x_space           = graph_width / (num_points - 1),
-           x_error           = graph_width - (x_space * (num_points - 1)),
-           y_spacing         = graph_height / num_lines_y;
-    double conversion_factor = graph_height / (max_value - min_value);
-
-    for (int i = 0; i < num_points; i++)
-    {
-        int x = (i < (num_points - 1)) ? (x_space * i) + left : (x_space * i) + x_error + left;
-        frame_draw_line(x, bottom, x, top, 1);
-        /* Draw x-axis time labels rotated otherwise they overlap with each other */
-        frame_draw_rotated_string(x - 8, bottom + 8, font12, hourly_forecast[i].time);
-    }
-
-    for (int i = 0; i <= num_lines_y; i++)
-    {
-        float label_value = min_value + ((max_value - min_value) / num_lines_y) * i;
-        int y = bottom - (i * y_spacing);
-        char label[16];
-
-        frame_draw_line(left, y, right, y, 1);
-
-        snprintf(label, sizeof(label), left_label_format, label_value);
-        frame_draw_string(left - (font12.width * strlen(label)) - 14, y - 6, font12, label);
-        frame_draw_circle(left - 12, y - 8, 2);
-
-        snprintf(label, sizeof(label), right_label_format, label_value);
-        frame_draw_string(right + 4, y - 6, font12, label);
-    }
-
-    for (int i = 1; i < num_points; i++)
-    {
-        int temp_y      = (int)bottom - round((hourly_forecast[i].temp - min_value) * conversion_factor),
-            temp_y_prev = (int)(bottom - round((hourly_forecast[i - 1].temp - min_value) * conversion_factor)),
-            precip_y    =
-                (int)(bottom - round((hourly_forecast[i].precipitation_chance - min_value) * conversion_factor)),
-            x           = (i < (num_points - 1)) ? (x_space * i) + left : (x_space * i) + x_error + left,
-            x_prev      = (x_space * (i - 1)) + left;
-
-        frame_draw_line(x_prev, temp_y_prev, x, temp_y, 3);
-
-        if (precip_y < bottom)
-        {
-            frame_draw_dotted_rectangle(x_prev, precip_y, x, bottom, 1);
-        }
-    }
+    ulp_main_cpu_active = 0;
+    ulp_riscv_timer_resume();
 }
 
-static char *float_to_string(float value)
-{
-    static char buffer[16];
-    if ((int)value == value)
-    {
-        snprintf(buffer, sizeof(buffer), "%d", (int)value); // Trim trailing .0 for whole numbers
-    } else {
-        snprintf(buffer, sizeof(buffer), "%.1f", value);
-    }
-    return buffer;
-}
+static const char *error_message = NULL;
 
-static uint16_t float_str_width(float value, uint16_t font_width)
+static void error_render_message(uint8_t *buffer, int top)
 {
-    char *str = float_to_string(value);
-    uint16_t str_width = strlen(str) * font_width;
-    if (font_width <= 22)
-    {
-        str_width -= (strchr(str, '.') != NULL) ? font_width : 0;
-    } else {
-        str_width -= (strchr(str, '.') != NULL) ? (font_width * 0.35) : 0;
-    }
-    return str_width;
+    frame_render_message(buffer, top, error_message);
 }
-
-static void frame_draw_forecast(int x, int y, struct weather_forecast forecast)
-{
-    frame_draw_string(x, y, font24, forecast.day);
-    frame_draw_icon(x, y + 30, forecast.id, true);
-    frame_draw_arrow(x + 60, y + 45, 0, 15);
-    frame_draw_string(x + 70, y + 30, font16, float_to_string(forecast.high_temp));
-    frame_draw_circle((x + 72 + float_str_width(forecast.high_temp, font16.width)), y + 25, 2);
-    frame_draw_arrow(x + 60, y + 45, 179, 15);
-    frame_draw_string(x + 70, y + 50, font16, float_to_string(forecast.low_temp));
-    frame_draw_circle((x + 72 + float_str_width(forecast.low_temp, font16.width)), y + 45, 2);
-    if (forecast.precipitation_chance > 0)
-    {
-        frame_draw_image(x + 42, y + 70, raindrop);
-        frame_draw_string(x + 68, y + 70, font16, float_to_string(forecast.precipitation_chance));
-        frame_draw_string(x + 68 + float_str_width(forecast.precipitation_chance, font16.width), y + 70,
-                font12, "%");
-    }
-}
-
-static void frame_draw_battery(int left, int top, int right, int bottom, uint8_t percentage)
+static void error_draw_message(const char *message)
 {
-    int tail_width = (right - left) / 10,
-        tail_height = (bottom - top) / 3,
-        body_width = (right - left) - tail_width,
-        body_height = bottom - top,
-        fill_point = (int)((percentage / 100.0f) * body_width);
-    /* Draw battery body */
-    frame_draw_line(left, top, left, bottom, 2);
-    frame_draw_line(left, top, left + body_width, top, 2);
-    frame_draw_line(left + body_width, top, left + body_width, bottom, 2);
-    frame_draw_line(left, bottom, left + body_width + 2, bottom, 2);
-    /* Draw battery tail */
-    frame_draw_line(right - tail_width, top + tail_height, right, top + tail_height, 2);
-    frame_draw_line(right - tail_width,
-            top + tail_height + tail_height, right + 2, top + tail_height + tail_height, 2);
-    frame_draw_line(right, top + tail_height, right, top + tail_height + tail_height, 2);
-    /* Draw battery level */
-    for (int i = top; i < bottom; i++)
+    /* Errors can be raised before or after the bus is set up, bus init is a no-op if it already is */
+    error_message = message;
+    refresh_mode_t mode = refresh_policy_choose(&refresh_policy, 0, 0, EPD_WIDTH, EPD_HEIGHT);
+    if (epd_init(&epd_bus_spi, mode != REFRESH_FULL) != ESP_OK)
     {
-        frame_draw_line(left, i, left + fill_point, i, 1);
+        return;
     }
-    frame_draw_string(right + 4, top + 2, font12, float_to_string(percentage));
-     frame_draw_string(right + 4 + float_str_width(percentage, font12.width), top + 2, font12, "%");
-}
-
-static void frame_draw_default()
-{
-    /* Quadrant 1: Current time and date */
-    UPDATE_TIME;
-    char timeinfo_str[64];
-    frame_draw_string(450, 20, font24, "It is ");
-    strftime(timeinfo_str, sizeof(timeinfo_str), "%A,", &timeinfo);
-    frame_draw_string(450 + (font24.width * strlen("It is ")), 20, font24, timeinfo_str);
-    strftime(timeinfo_str, sizeof(timeinfo_str), "%B %d, %Y", &timeinfo);
-    frame_draw_string(470, 50, font24, timeinfo_str);
-    frame_draw_time(CLOCK_X, CLOCK_Y);
-    frame_draw_battery(730, 5, 770, 20, battery_percentage);
-
-    /* Quadrant 2: Current weather conditions */
-    frame_draw_icon(20, 20, weather.id, false);
-    frame_draw_string(10, 130, font20, "Currently, ");
-    frame_draw_string(30, 160, font40, float_to_string(weather.current_temp));
-    frame_draw_circle(30 + float_str_width(weather.current_temp, font40.width), 165, 5);
-    frame_draw_string(140, 180, font20, "feels like");
-    frame_draw_string(290, 176, font24, float_to_string(weather.feels_like_temp));
-    frame_draw_circle((292 + float_str_width(weather.feels_like_temp, font24.width)), 176, 3);
-    frame_draw_string(175, 20, font24, "High");
-    frame_draw_arrow(185 + (4 * font24.width), 40, 0, 20);
-    frame_draw_string(260, 20, font24, float_to_string(weather.high_temp));
-    frame_draw_circle((262 + float_str_width(weather.high_temp, font24.width)), 20, 3);
-    frame_draw_string(175, 50, font24, " Low");
-    frame_draw_arrow(185 + (4 * font24.width), 50, 179, 20);
-    frame_draw_string(260, 50, font24, float_to_string(weather.low_temp));
-    frame_draw_circle((262 + float_str_width(weather.low_temp, font24.width)), 50, 3);
-    frame_draw_string(175, 80, font16, "Wind");
-    frame_draw_string(175, 95, font16, "Speed");
-    frame_draw_image(235, 75, wind);
-    frame_draw_string(285, 85, font24, float_to_string(weather.wind_speed));
-    frame_draw_string((288 + float_str_width(weather.wind_speed, font24.width)), 90, font12, "mph");
-    frame_draw_compass(400, 100, weather.wind_direction_degrees, 15);
-    frame_draw_string(175, 125, font16, "Cloud");
-    frame_draw_string(175, 140, font16, "Cover");
-    frame_draw_image(240, 120, cloud_small);
-    frame_draw_string(295, 130, font24, float_to_string(weather.cloudiness));
-    frame_draw_string(295 + float_str_width(weather.cloudiness, font24.width), 125, font20, "%");
-
-    /* Quadrant 3: Graph showing temperature and precipitaion chance */
-    frame_draw_graph(42, 240, 384, 430, 0, 100, hourly_forecast, FORECAST_HOURS, 10, "%.0fF", "%.0f%%");
-
-    /* Quadrant 4: Forecast for next few days */
-    frame_draw_forecast(445, 235, forecast[1]);
-    frame_draw_forecast(565, 235, forecast[2]);
-    frame_draw_forecast(685, 235, forecast[3]);
-    frame_draw_forecast(445, 360, forecast[4]);
-    frame_draw_forecast(565, 360, forecast[5]);
-    frame_draw_forecast(685, 360, forecast[6]);
-}
-
-static void error_draw_message(const char *message)
-{
-    /* Clear the frame */
-    memset(frame, 0x00, sizeof(frame));
-    /* Draw error message in the middle of the screen */
-    int x = (EPD_WIDTH - (strlen(message) * font40.width)) / 2;
-    int y = (EPD_HEIGHT - font40.height) / 2;
-    frame_draw_string(x, y, font40, message);
-    epd_init();
-    epd_write_frame();
+    epd_write_banded(error_render_message);
     epd_sleep();
+    refresh_policy_record(&refresh_policy, mode, 0, 0, EPD_WIDTH, EPD_HEIGHT);
+    frame_diff_invalidate(); // Screen no longer shows the last frame
+    widget_invalidate_inputs(); // Nor do the widgets
+    ulp_shown_hours = 0; // Nor the clock the ULP draws
 }
 
 static void error_handler(enum error_type type, const char *message)
@@ -868,6 +258,16 @@ static void error_handler(enum error_type type, const char *message)
         esp_sleep_enable_timer_wakeup(UINT64_MAX);
     } else {
         deferred_uS = (5ULL * 1000ULL * 1000ULL) << error_count[type]; // Exponential backoff, up to ~1.5 hours
+        if (ulp_held)
+        {
+            /* The clock keeps going until the retry. The ULP skipped the minutes it was held for, and needs the
+             * pins back if the error left them with the SPI bus */
+            UPDATE_TIME;
+            ulp_set_time();
+            epd_spi_release();
+            rtc_gpio_set_low_all();
+            ulp_release();
+        }
         esp_sleep_enable_timer_wakeup(deferred_uS);
     }
     esp_deep_sleep_start();
@@ -931,10 +331,8 @@ static uint32_t battery_get_voltage()
 
 static uint8_t battery_get_percentage()
 {
-    float voltage = ((float)battery_get_voltage()) / 1000, // Convert mV to V
-        /* Polynomial regression to fit the discharge curve of a typical Lipo battery, clamped to 0-100% */
-          percentage = 123 - (123 / pow((1 + pow((voltage / 3.7), 80)), 0.165));
-    uint8_t percentage_clamped = (percentage < 0) ? 0 : ((percentage > 100) ? 100 : (uint8_t)round(percentage));
+    /* Polynomial regression to fit the discharge curve of a typical Lipo battery, precomputed as a table */
+    uint8_t percentage_clamped = fixed_battery_percentage(battery_get_voltage());
     ESP_LOGI("battery", "Battery percentage: %d%%", percentage_clamped);
     return percentage_clamped;
 }
@@ -1276,15 +674,6 @@ static void rtc_gpio_init_all()
     rtc_gpio_set_level(RST_PIN, HIGH);
 }
 
-static void rtc_gpio_set_low_all()
-{
-    rtc_gpio_set_level(CS_PIN, LOW);
-    rtc_gpio_set_level(DC_PIN, LOW);
-    rtc_gpio_set_level(RST_PIN, LOW);
-    rtc_gpio_set_level(MOSI_PIN, LOW);
-    rtc_gpio_set_level(SCK_PIN, LOW);
-}
-
 static void align_time_to_next_minute()
 {
     UPDATE_TIME;
@@ -1297,9 +686,7 @@ static void align_time_to_next_minute()
     vTaskDelay((seconds_to_next_minute * 1000) / portTICK_PERIOD_MS);
 
     UPDATE_TIME;
-    ulp_hours = timeinfo.tm_hour % 12;
-    ulp_hours = (ulp_hours == 0) ? 12 : ulp_hours;
-    ulp_minutes = timeinfo.tm_min;
+    ulp_set_time();
 }
 
 static void task_wifi_start(void *pvParameters)
@@ -1338,8 +725,23 @@ static void task_https_get_weather(void *pvParameters)
     vTaskDelete(NULL);
 }
 
+static void frame_render_start()
+{
+    render_ahead = malloc(EPD_BAND_SIZE);
+    render_done = xSemaphoreCreateBinary();
+    error_check(render_ahead != NULL && render_done != NULL, MEMORY_ERROR, "Failed to allocate render task");
+    error_check(xTaskCreatePinnedToCore(task_render_ahead, "render_ahead", 4096, NULL, 5, &render_task, 1) == pdPASS,
+            MEMORY_ERROR, "Failed to create render task");
+}
+
+
 void app_main()
 {
+    esp_sleep_wakeup_cause_t wakeup_cause = esp_sleep_get_wakeup_cause();
+    if (wakeup_cause == ESP_SLEEP_WAKEUP_ULP || wakeup_cause == ESP_SLEEP_WAKEUP_TIMER)
+    {
+        ulp_hold(); // Before anything else touches the pins
+    }
     vTaskDelay(2000 / portTICK_PERIOD_MS); // Delay for serial monitor
     /* Default log level is set to ERROR to speed up boot time, set it back to INFO */
     esp_log_level_set("*", ESP_LOG_INFO);
@@ -1356,14 +758,17 @@ void app_main()
         error_esp(OTHER_ERROR, nvs_flash_init());
     }
 
-    esp_sleep_wakeup_cause_t wakeup_cause = esp_sleep_get_wakeup_cause();
     // TODO: If woken up from ULP draw next minutes frame
     if (wakeup_cause == ESP_SLEEP_WAKEUP_ULP || wakeup_cause == ESP_SLEEP_WAKEUP_TIMER)
     {
         ESP_LOGI("main", "Woken up from deep sleep");
+        ESP_LOGI("ulp", "%lu bytes written, last window at %lu cycles per byte where the old path takes %lu",
+                (unsigned long)ulp_bytes_written, (unsigned long)ulp_cycles_per_byte,
+                (unsigned long)ulp_baseline_cycles_per_byte);
     } else {
         /* Init ULP so its variables can be accessed and modified from the main CPU */
         error_esp(OTHER_ERROR, ulp_riscv_load_binary(bin_start, (bin_end - bin_start)));
+        refresh_policy_reset(&refresh_policy); // Panel contents are unknown after a cold boot
         ulp_set_wakeup_period(0, 10);
         error_esp(OTHER_ERROR, ulp_riscv_run()); // Exits immediately after starting
     }
@@ -1374,6 +779,10 @@ void app_main()
 
     event_group = xEventGroupCreate();
     error_check(event_group != NULL, MEMORY_ERROR, "Failed to create event group for task synchronization");
+    /* Only starts the band worker, core 1 does nothing while the fetch runs. The chrome is rendered at build
+     * time and every other band holds something drawn from the time or the weather, the battery included as
+     * its band is shared with the date, so none of them can be finished before the network tasks are */
+    frame_render_start();
     xTaskCreate(task_wifi_start, "wifi_start", 4096, NULL, 5, NULL);
     xTaskCreate(task_sntp_sync_time, "sntp_sync_time", 4096, NULL, 5, NULL);
     xTaskCreate(task_https_get_weather, "https_get_weather", 65536, NULL, 5, NULL);
@@ -1383,15 +792,63 @@ void app_main()
     vEventGroupDelete(event_group);
     ESP_LOGI("main", "All tasks complete, proceeding to draw frame and enter deep sleep");
 
-    epd_init();
-    frame_draw_default();
-    epd_write_frame();
-    epd_sleep();
+    UPDATE_TIME; // Snapshot once so every band is drawn from the same time
+    ESP_LOGI("time", "Drawing frame for %02d:%02d", timeinfo.tm_hour, timeinfo.tm_min);
+#if defined(FRAME_BENCHMARK)
+    error_esp(MEMORY_ERROR, frame_benchmark(stdout));
+#endif
+    frame_record_default();
+    /* The ULP has redrawn the clock every minute since, and none of its minutes are in the stored frame */
+    frame_diff_drawn_over(CLOCK_X, CLOCK_Y, CLOCK_WIDTH, CLOCK_HEIGHT);
+    frame_diff_t diff;
+    error_esp(MEMORY_ERROR, frame_diff_compute(frame_render_parallel, widget_check_inputs(), &diff));
+    if (diff.full || diff.count > 0)
+    {
+        /* Every window has to fit the ghosting budget for the update to stay partial */
+        refresh_mode_t mode = diff.full ? refresh_policy_choose(&refresh_policy, 0, 0, EPD_WIDTH, EPD_HEIGHT)
+            : REFRESH_PARTIAL;
+        for (int i = 0; i < diff.count && !diff.full; i++)
+        {
+            refresh_mode_t rect_mode = refresh_policy_choose(&refresh_policy,
+                    diff.rects[i].x, diff.rects[i].y, diff.rects[i].width, diff.rects[i].height);
+            mode = (rect_mode > mode) ? rect_mode : mode;
+        }
+        ESP_LOGI("refresh", "Using %s refresh", refresh_mode_names[mode]);
+
+        error_esp(EPD_ERROR, epd_init(&epd_bus_spi, mode != REFRESH_FULL));
+        if (mode == REFRESH_PARTIAL)
+        {
+            epd_write_partial(diff.rects, diff.count, frame_render_parallel);
+        } else {
+            epd_write_banded(frame_render_parallel);
+        }
+        error_esp(EPD_ERROR, epd_sleep()); // ULP needs the pins back on RTC GPIO
+        error_check(epd_bus_stats.busy_timeouts == 0, EPD_ERROR, "Display stayed busy past its timeout");
+
+        if (mode == REFRESH_PARTIAL)
+        {
+            for (int i = 0; i < diff.count; i++)
+            {
+                refresh_policy_record(&refresh_policy, mode,
+                        diff.rects[i].x, diff.rects[i].y, diff.rects[i].width, diff.rects[i].height);
+            }
+        } else {
+            refresh_policy_record(&refresh_policy, mode, 0, 0, EPD_WIDTH, EPD_HEIGHT);
+        }
+        refresh_policy_log();
+    } else {
+        ESP_LOGI("main", "Frame unchanged, skipping refresh");
+    }
+    frame_diff_commit();
+    widget_commit_inputs();
+    /* The ULP only sends the clock digits that differ from the ones drawn here */
+    ulp_shown_hours = ((timeinfo.tm_hour % 12) == 0) ? 12 : (timeinfo.tm_hour % 12);
+    ulp_shown_minutes = timeinfo.tm_min;
     rtc_gpio_set_low_all();
 
     align_time_to_next_minute();
     ulp_set_wakeup_period(0, (60ULL * 1000ULL * 1000ULL)); // 60 seconds in uS
-    ulp_riscv_timer_resume();
+    ulp_release();
 
     error_esp(OTHER_ERROR, esp_sleep_enable_ulp_wakeup());
     esp_sleep_enable_timer_wakeup(180ULL * 60ULL * 1000ULL * 1000ULL); // 3 hours in uS
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Packs the font tables in src/fonts.c for the firmware, run by src/CMakeLists.txt at build time.
+
+Most glyph rows are blank, so each glyph only keeps the rows between its first and last non-blank row.
+The rows kept are stored as is (whole bytes, MSB first) so they can be blitted straight from flash, and
+a glyph table gives where each glyph's rows start in the packed table and which row they belong at.
+
+Usage: font_pack.py <fonts.c> <output.c> <font>:<table>:<width>:<height>[:<rotated table>]...
+
+The optional rotated table is the name of the font's table generated by font_rotate.py.
+"""
+
+import re
+import sys
+
+BITS_PER_BYTE = 8
+
+
+def read_table(source, name):
+    match = re.search(r"\b" + re.escape(name) + r"\s*\[\]\s*=\s*\{(.*?)\};", source, re.S)
+    if match is None:
+        sys.exit(f"font_pack.py: table {name} not found")
+    body = re.sub(r"//[^\n]*|/\*.*?\*/", "", match.group(1), flags=re.S)
+    return [int(value, 16) for value in re.findall(r"0x[0-9a-fA-F]+", body)]
+
+
+def pack_font(table, width, height):
+    stride = (width + BITS_PER_BYTE - 1) // BITS_PER_BYTE
+    glyph_size = stride * height
+    if len(table) % glyph_size != 0:
+        return None, None
+    rows, glyphs = [], []
+    for start in range(0, len(table), glyph_size):
+        glyph = [table[start + row * stride:start + (row + 1) * stride] for row in range(height)]
+        used = [row for row in range(height) if any(glyph[row])]
+        first = used[0] if used else 0
+        count = (used[-1] - first + 1) if used else 0
+        glyphs.append((len(rows) * stride, first, count))
+        rows.extend(glyph[first:first + count])
+    return rows, glyphs
+
+
+def main():
+    if len(sys.argv) < 4:
+        sys.exit(__doc__)
+    with open(sys.argv[1]) as f:
+        source = f.read()
+
+    out = ["/* Generated by tools/font_pack.py from src/fonts.c, do not edit */", "",
+           '#include "fonts.h"', ""]
+    raw_total = packed_total = 0
+    for spec in sys.argv[3:]:
+        font, name, width, height, *rotated = spec.split(":")
+        width, height = int(width), int(height)
+        table = read_table(source, name)
+        rows, glyphs = pack_font(table, width, height)
+        if rows is None:
+            sys.exit(f"font_pack.py: {name} is not a whole number of {width}x{height} glyphs")
+        packed = sum(len(row) for row in rows)
+        offset_max = max(offset for offset, _, _ in glyphs)
+        if offset_max > 0xffff:
+            sys.exit(f"font_pack.py: {name} is too large for 16-bit glyph offsets")
+        raw_total += len(table)
+        packed_total += packed + len(glyphs) * 4
+
+        out.append(f"/* {name}: {len(table)} bytes unpacked, {packed} bytes of rows and {len(glyphs)} glyphs */")
+        out.append(f"static const uint8_t {font}_rows[] =")
+        out.append("{")
+        for row in rows:
+            out.append("    " + " ".join(f"0x{b:02x}," for b in row))
+        out.append("};")
+        out.append("")
+        out.append(f"static const font_glyph_t {font}_glyphs[] =")
+        out.append("{")
+        for offset, first, count in glyphs:
+            out.append(f"    {{ {offset}, {first}, {count} }},")
+        out.append("};")
+        out.append("")
+        out.append(f"font_t {font} =")
+        out.append("{")
+        out.append(f"    .width = {width},")
+        out.append(f"    .height = {height},")
+        out.append(f"    .table = {font}_rows,")
+        out.append(f"    .glyphs = {font}_glyphs,")
+        if rotated:
+            out.append(f"    .rotated_table = {rotated[0]},")
+        out.append("};")
+        out.append("")
+
+    with open(sys.argv[2], "w") as f:
+        f.write("\n".join(out))
+    print(f"font_pack.py: {raw_total} bytes of font tables packed into {packed_total}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Generates rotated copies of font tables in src/fonts.c, run by src/CMakeLists.txt at build time.
+
+Glyphs are turned 90 degrees anticlockwise, the same way frame_draw_rotated_char() turns them, and are
+written out in the same layout as the source table: rows of whole bytes, MSB first, glyphs in ASCII
+order starting at ' '. A font W pixels wide and H high becomes H wide and W high.
+
+Usage: font_rotate.py <fonts.c> <output.c> <table>:<width>:<height>...
+"""
+
+import re
+import sys
+
+BITS_PER_BYTE = 8
+
+
+def read_table(source, name):
+    match = re.search(r"\b" + re.escape(name) + r"\s*\[\]\s*=\s*\{(.*?)\};", source, re.S)
+    if match is None:
+        sys.exit(f"font_rotate.py: table {name} not found")
+    body = re.sub(r"//[^\n]*|/\*.*?\*/", "", match.group(1), flags=re.S)
+    return [int(value, 16) for value in re.findall(r"0x[0-9a-fA-F]+", body)]
+
+
+def bytes_per_row(width):
+    return (width + BITS_PER_BYTE - 1) // BITS_PER_BYTE
+
+
+def rotate_glyph(glyph, width, height):
+    src_stride = bytes_per_row(width)
+    dst_stride = bytes_per_row(height)
+    rotated = [0] * (dst_stride * width)
+    for row in range(width):
+        for col in range(height):
+            old_row = height - 1 - col
+            old_col = row
+            if glyph[old_row * src_stride + old_col // BITS_PER_BYTE] & (0x80 >> (old_col % BITS_PER_BYTE)):
+                rotated[row * dst_stride + col // BITS_PER_BYTE] |= 0x80 >> (col % BITS_PER_BYTE)
+    return rotated
+
+
+def main():
+    if len(sys.argv) < 4:
+        sys.exit(__doc__)
+    with open(sys.argv[1]) as f:
+        source = f.read()
+
+    out = ["/* Generated by tools/font_rotate.py from src/fonts.c, do not edit */", "",
+           '#include "fonts.h"', ""]
+    for spec in sys.argv[3:]:
+        name, width, height = spec.split(":")
+        width, height = int(width), int(height)
+        table = read_table(source, name)
+        glyph_size = bytes_per_row(width) * height
+        if len(table) % glyph_size != 0:
+            sys.exit(f"font_rotate.py: {name} is not a whole number of {width}x{height} glyphs")
+
+        out.append(f"/* {name} rotated, {height} pixels wide and {width} high */")
+        out.append(f"const uint8_t {name}_rotated[] =")
+        out.append("{")
+        for index in range(len(table) // glyph_size):
+            glyph = table[index * glyph_size:(index + 1) * glyph_size]
+            rotated = rotate_glyph(glyph, width, height)
+            stride = bytes_per_row(height)
+            out.append(f"    // '{chr(ord(' ') + index)}'" if chr(ord(' ') + index) != "\\" else "    // backslash")
+            for row in range(width):
+                out.append("    " + " ".join(f"0x{b:02x}," for b in rotated[row * stride:(row + 1) * stride]))
+        out.append("};")
+        out.append("")
+
+    with open(sys.argv[2], "w") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "display.h"
+#include "epd.h"
+#include "epd_bus.h"
+#include "epd_spi.h"
+
+/* Drives epd.c over the SPI bus with the host mock in epd_spi.c standing in for GPSPI2, and checks the
+ * stream the panel would get and how many transactions it takes:
+ * - epd_write_frame() of a whole frame is one command, then the frame split at EPD_SPI_MAX_TRANSFER
+ * - epd_write_banded() sends the same frame band by band, each band its own transaction, and every band
+ *   is rendered exactly once
+ * The bus' own counters are checked against the mock too, they are what the device logs */
+
+static int failures = 0;
+static int bands_rendered = 0;
+
+static void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static uint8_t pattern(int y, int byte)
+{
+    return (uint8_t)((y * 3) ^ byte);
+}
+
+static void render_pattern(uint8_t *band, int top)
+{
+    for (int y = 0; y < EPD_BAND_HEIGHT; y++)
+    {
+        for (int byte = 0; byte < EPD_BYTE_WIDTH; byte++)
+        {
+            band[(y * EPD_BYTE_WIDTH) + byte] = pattern(top + y, byte);
+        }
+    }
+    bands_rendered++;
+}
+
+/* Stream after epd_init() is the command, the frame, then the refresh */
+static void check_frame_stream(const char *name, size_t transactions_expected)
+{
+    size_t length, transactions = epd_spi_mock_transactions();
+    const uint16_t *stream = epd_spi_mock_stream(&length);
+    const size_t frame_size = EPD_HEIGHT * EPD_BYTE_WIDTH;
+    char what[128];
+
+    snprintf(what, sizeof(what), "%s: %zu entries, expected %zu", name, length, frame_size + 2);
+    expect(length == frame_size + 2, what);
+    if (length != frame_size + 2)
+    {
+        return;
+    }
+    expect(stream[0] == (EPD_SPI_MOCK_COMMAND | TRANSFER_DATA_2), "frame starts with TRANSFER_DATA_2");
+    for (size_t i = 0; i < frame_size; i++)
+    {
+        if (stream[1 + i] != pattern(i / EPD_BYTE_WIDTH, i % EPD_BYTE_WIDTH))
+        {
+            snprintf(what, sizeof(what), "%s: frame byte %zu is %03x", name, i, stream[1 + i]);
+            expect(false, what);
+            break;
+        }
+    }
+    expect(stream[length - 1] == (EPD_SPI_MOCK_COMMAND | DISPLAY_REFRESH), "frame ends with DISPLAY_REFRESH");
+    snprintf(what, sizeof(what), "%s: %zu transactions, expected %zu", name, transactions, transactions_expected);
+    expect(transactions == transactions_expected, what);
+    snprintf(what, sizeof(what), "%s: bus counted %lu transactions", name,
+            (unsigned long)epd_bus_stats.transactions);
+    expect(epd_bus_stats.transactions == transactions, what);
+    expect(epd_bus_stats.commands == 2 && epd_bus_stats.data_bytes == frame_size, "bus counted bytes");
+}
+
+/* epd_init() with the full waveform, every command and data byte is a transaction of its own */
+static void check_init_stream(void)
+{
+#define C(command) (EPD_SPI_MOCK_COMMAND | (command))
+    static const uint16_t expected[] =
+    {
+        C(BOOSTER_SOFT_START), 0x17, 0x17, 0x27, 0x17,
+        C(POWER_SETTING), 0x07, 0x17, 0x3f, 0x3f,
+        C(POWER_ON),
+        C(PANEL_SETTING), 0x1f,
+        C(RESOLUTION_SETTING), 0x03, 0x20, 0x01, 0xe0,
+        C(DUAL_SPI), 0x00,
+        C(TCON_SETTING), 0x22,
+        C(VCOM_DATA_INTERVAL), 0x18, 0x07
+    };
+#undef C
+    size_t length;
+    const uint16_t *stream = epd_spi_mock_stream(&length);
+
+    expect(length == sizeof(expected) / sizeof(expected[0])
+            && memcmp(stream, expected, sizeof(expected)) == 0, "init sequence");
+    expect(epd_spi_mock_transactions() == length, "init sends every byte as its own transaction");
+}
+
+int main(void)
+{
+    static uint8_t frame[EPD_HEIGHT][EPD_BYTE_WIDTH];
+    const size_t chunks = ((sizeof(frame) + EPD_SPI_MAX_TRANSFER - 1) / EPD_SPI_MAX_TRANSFER);
+
+    for (int y = 0; y < EPD_HEIGHT; y++)
+    {
+        for (int byte = 0; byte < EPD_BYTE_WIDTH; byte++)
+        {
+            frame[y][byte] = pattern(y, byte);
+        }
+    }
+
+    epd_spi_mock_reset();
+    expect(epd_init(&epd_bus_spi, false) == ESP_OK, "epd_init");
+    check_init_stream();
+
+    epd_spi_mock_reset();
+    epd_bus_stats = (epd_bus_stats_t){ 0 };
+    epd_write_frame(frame[0], sizeof(frame));
+    check_frame_stream("epd_write_frame", 1 + chunks + 1);
+
+    epd_spi_mock_reset();
+    epd_bus_stats = (epd_bus_stats_t){ 0 };
+    epd_write_banded(render_pattern);
+    check_frame_stream("epd_write_banded", 1 + EPD_BANDS + 1);
+    expect(bands_rendered == EPD_BANDS, "every band rendered once");
+
+    expect(epd_sleep() == ESP_OK, "epd_sleep");
+    epd_spi_mock_reset();
+    printf("%s\n", (failures == 0) ? "OK" : "FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
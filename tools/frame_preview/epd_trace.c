@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "display.h"
+#include "epd.h"
+#include "epd_bus.h"
+#include "refresh_policy.h"
+#include "soc/rtc.h"
+
+/* Records what the display driver and the ULP send to the panel through the trace bus, in the format
+ * described in epd_bus.h, so changes to either show up as a diff against test/golden:
+ * - epd_init(), epd_write_frame() and epd_write_partial() from epd.c, with a short frame and small windows
+ *   of a test pattern since it's the command sequence that matters rather than 48KB of pixels
+ * - ulp/clock.c built for the host, with its pin writes decoded back into bytes. It draws 1:07 on a panel
+ *   it knows nothing about, which takes a full refresh and every character, then 1:08 and 1:59
+ *
+ * Usage: epd_trace <main.trace> <ulp.trace> */
+
+#define FRAME_ROWS 4
+
+/* ULP program and the variables the main CPU sees as ulp_* on the device */
+int ulp_clock_main(void);
+extern volatile uint32_t hours, minutes, shown_hours, shown_minutes, clk_cal, wakeups;
+extern refresh_policy_t refresh_policy;
+
+static void render_pattern(uint8_t *band, int top)
+{
+    for (int i = 0; i < EPD_BAND_SIZE; i++)
+    {
+        band[i] = (uint8_t)((top + (i / EPD_BYTE_WIDTH)) ^ i);
+    }
+}
+
+static esp_err_t trace_main(const char *path)
+{
+    static uint8_t frame[FRAME_ROWS * EPD_BYTE_WIDTH];
+    const epd_rect_t rects[] = { { 8, 38, 16, 4 }, { 776, 476, 24, 4 } };
+
+    for (size_t i = 0; i < sizeof(frame); i++)
+    {
+        frame[i] = (uint8_t)(i * 7);
+    }
+    epd_bus_trace_set_path(path);
+    if (epd_init(&epd_bus_trace, true) != ESP_OK)
+    {
+        return ESP_FAIL;
+    }
+    epd_write_frame(frame, sizeof(frame));
+    epd_write_partial(rects, sizeof(rects) / sizeof(rects[0]), render_pattern);
+    return epd_sleep();
+}
+
+static esp_err_t trace_ulp(const char *path)
+{
+    static const uint32_t times[][2] = { { 1, 7 }, { 1, 8 }, { 1, 59 } };
+
+    epd_bus_trace_set_path(path);
+    if (epd_bus_trace.init() != ESP_OK)
+    {
+        return ESP_FAIL;
+    }
+    /* As app_main() leaves it before the first deep sleep, with the panel contents unknown */
+    refresh_policy_reset(&refresh_policy);
+    clk_cal = 1 << RTC_CLK_CAL_FRACT;
+    wakeups = 1;
+    shown_hours = 0;
+    for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); i++)
+    {
+        hours = times[i][0];
+        minutes = times[i][1];
+        ulp_clock_main();
+    }
+    return epd_bus_trace.release();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <main.trace> <ulp.trace>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (trace_main(argv[1]) != ESP_OK)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (trace_ulp(argv[2]) != ESP_OK)
+    {
+        perror(argv[2]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,182 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "fixed_math.h"
+
+/* Checks src/fixed_math.c against the libm formulas it replaced in the drawing and battery code. Each check
+ * has the tolerance it is allowed, and prints the largest difference it saw so drift shows before it fails:
+ * - fixed_sin() and fixed_cos(): within 1 Q15 step of sin() and cos() at every whole degree, which the
+ *   old arrows converted to radians in float
+ * - fixed_div_round() and fixed_map(): exactly round() of the same division in double, except that where
+ *   the exact result is halfway between two integers fixed_map() rounds away from zero while the double
+ *   factor can land just short of the half and round down, so those are allowed to differ by 1
+ * - fixed_arrow(): the same corners frame_draw_arrow() used to compute in double, at every degree with lengths
+ *   15 and 20, except where the double value lands within NEAR_INTEGER of where it rounds but not on it. There
+ *   the float radians decided which way it went and Q15 can't follow, so those are allowed to differ by 1
+ * - fixed_battery_percentage(): within 1% of the pow() discharge curve, from 3.0 to 4.5V in 1mV steps */
+
+#define SIN_TOLERANCE        1 // Q15 steps
+#define MAP_TOLERANCE        0
+#define MAP_TIE_TOLERANCE    1
+#define ARROW_TOLERANCE      0
+#define ARROW_NEAR_TOLERANCE 1
+#define NEAR_INTEGER         0.001 // Further than the Q15 sine's error can move a corner of an arrow of length 20
+#define BATTERY_TOLERANCE    1 // Percent
+
+static int failures = 0;
+
+static void check(const char *name, long worst, long tolerance, long checked)
+{
+    printf("%-26s %ld checked, worst difference %ld, tolerance %ld\n", name, checked, worst, tolerance);
+    if (worst > tolerance)
+    {
+        failures++;
+    }
+}
+
+static void check_sin_cos(void)
+{
+    long worst_sin = 0, worst_cos = 0, checked = 0;
+
+    for (int degrees = -720; degrees <= 720; degrees++)
+    {
+        float radians = degrees * (M_PI / 180.0f); // As frame_draw_arrow() converted them
+        long sin_error = labs(fixed_sin(degrees) - lround(sin(radians) * FIXED_Q15_ONE)),
+             cos_error = labs(fixed_cos(degrees) - lround(cos(radians) * FIXED_Q15_ONE));
+        worst_sin = (sin_error > worst_sin) ? sin_error : worst_sin;
+        worst_cos = (cos_error > worst_cos) ? cos_error : worst_cos;
+        checked++;
+    }
+    check("fixed_sin", worst_sin, SIN_TOLERANCE, checked);
+    check("fixed_cos", worst_cos, SIN_TOLERANCE, checked);
+}
+
+static void check_div_map(void)
+{
+    long worst_div = 0, worst_map = 0, worst_tie = 0, div_checked = 0, map_checked = 0, tie_checked = 0;
+
+    for (int32_t numerator = -2000; numerator <= 2000; numerator++)
+    {
+        for (int32_t denominator = -40; denominator <= 40; denominator++)
+        {
+            if (denominator == 0)
+            {
+                continue;
+            }
+            long error = labs(fixed_div_round(numerator, denominator) - lround((double)numerator / denominator));
+            worst_div = (error > worst_div) ? error : worst_div;
+            div_checked++;
+        }
+    }
+    check("fixed_div_round", worst_div, MAP_TOLERANCE, div_checked);
+
+    /* Graph points as frame_draw_graph() scales them: values in hundredths onto the graph's height, which
+     * used to be round((value - min) * (height / (max - min))) with the factor in double */
+    static const int32_t ranges[][2] = { { 0, 10000 }, { -1500, 4500 }, { 2512, 5829 }, { -4000, -100 } };
+    for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++)
+    {
+        const int32_t min = ranges[i][0], max = ranges[i][1];
+        for (int32_t height = 1; height <= 480; height += 7)
+        {
+            double factor = (double)height / (max - min);
+            for (int32_t value = min; value <= max; value++)
+            {
+                long error = labs(fixed_map(value, min, max, height) - lround((value - min) * factor));
+                if (((2 * (value - min) * height) % (max - min)) == 0 && (((value - min) * height) % (max - min)) != 0)
+                {
+                    worst_tie = (error > worst_tie) ? error : worst_tie;
+                    tie_checked++;
+                } else {
+                    worst_map = (error > worst_map) ? error : worst_map;
+                    map_checked++;
+                }
+            }
+        }
+    }
+    check("fixed_map", worst_map, MAP_TOLERANCE, map_checked);
+    check("fixed_map halfway", worst_tie, MAP_TIE_TOLERANCE, tie_checked);
+}
+
+/* Whether value is within NEAR_INTEGER of edge, the integer truncation or the half round() changes at */
+static bool near_edge(double value, double edge)
+{
+    double distance = fabs((value - floor(value)) - edge);
+    return distance != 0 && (distance < NEAR_INTEGER || (1 - distance) < NEAR_INTEGER);
+}
+
+static void check_arrow(void)
+{
+    /* The compass and the first forecast card, arrows elsewhere only point straight up or down */
+    static const int origins[][2] = { { 400, 100 }, { 505, 280 } };
+    long worst = 0, worst_near = 0, checked = 0, near_checked = 0;
+
+    for (size_t i = 0; i < sizeof(origins) / sizeof(origins[0]); i++)
+    {
+        const int x = origins[i][0], y = origins[i][1];
+        for (int length = 15; length <= 20; length += 5)
+        {
+            for (int degrees = 0; degrees < 360; degrees++)
+            {
+                /* As frame_draw_arrow() used to: the tip truncated, the head's corners rounded */
+                float radians = degrees * (M_PI / 180.0f);
+                double dx = sin(radians),
+                       dy = -cos(radians),
+                       base_cx = x + 0.50 * length * dx,
+                       base_cy = y + 0.50 * length * dy,
+                       expected[3][2] =
+                       {
+                           { x + length * dx, y + length * dy },
+                           { base_cx + 0.30 * length * dy, base_cy + 0.30 * length * -dx },
+                           { base_cx - 0.30 * length * dy, base_cy - 0.30 * length * -dx },
+                       };
+                int points[3][2];
+                fixed_arrow(x, y, degrees, length, points);
+                for (int point = 0; point < 3; point++)
+                {
+                    for (int axis = 0; axis < 2; axis++)
+                    {
+                        double value = expected[point][axis];
+                        long rounded = (point == 0) ? (long)value : lround(value),
+                             error = labs(points[point][axis] - rounded);
+                        if (near_edge(value, (point == 0) ? 0 : 0.5))
+                        {
+                            worst_near = (error > worst_near) ? error : worst_near;
+                            near_checked++;
+                        } else {
+                            worst = (error > worst) ? error : worst;
+                            checked++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    check("fixed_arrow", worst, ARROW_TOLERANCE, checked);
+    check("fixed_arrow near edge", worst_near, ARROW_NEAR_TOLERANCE, near_checked);
+}
+
+static void check_battery(void)
+{
+    long worst = 0, checked = 0;
+
+    for (uint32_t millivolts = 3000; millivolts <= 4500; millivolts++)
+    {
+        double volts = millivolts / 1000.0,
+               percentage = 123 - (123 / pow(1 + pow(volts / 3.7, 80), 0.165));
+        long expected = (percentage < 0) ? 0 : ((percentage > 100) ? 100 : lround(percentage)),
+             error = labs(fixed_battery_percentage(millivolts) - expected);
+        worst = (error > worst) ? error : worst;
+        checked++;
+    }
+    check("fixed_battery_percentage", worst, BATTERY_TOLERANCE, checked);
+}
+
+int main(void)
+{
+    check_sin_cos();
+    check_div_map();
+    check_arrow();
+    check_battery();
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "display.h"
+#include "epd.h"
+#include "frame.h"
+#include "frame_chrome.h"
+
+/* Draws the chrome with frame_draw_chrome() in src/frame.c, the same primitives the widgets use, and writes
+ * it out as the source of src/frame_chrome.c. Blank rows are left out and rows that repeat are stored once.
+ * The frame_chrome test runs it and compares the result with the copy checked in, after changing the chrome:
+ *   build/frame_preview/frame_chrome_gen src/frame_chrome.c */
+
+#define BYTES_PER_LINE 20
+
+/* Nothing in the chrome depends on the inputs, but the widgets next to it in frame.c need them defined */
+struct tm timeinfo;
+uint8_t battery_percentage;
+struct weather_today weather;
+struct hourly_forecast hourly_forecast[FORECAST_HOURS];
+struct weather_forecast forecast[FORECAST_DAYS];
+
+static bool row_blank(const uint8_t *row)
+{
+    for (int i = 0; i < EPD_BYTE_WIDTH; i++)
+    {
+        if (row[i] != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t frame[EPD_HEIGHT][EPD_BYTE_WIDTH];
+    static int row_index[EPD_HEIGHT];
+    static int stored[EPD_HEIGHT]; // Frame row each stored row was first seen at
+    int count = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <frame_chrome.c>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (int top = 0; top < EPD_HEIGHT; top += EPD_BAND_HEIGHT)
+    {
+        frame_render_chrome(frame[top], top);
+    }
+    for (int y = 0; y < EPD_HEIGHT; y++)
+    {
+        row_index[y] = FRAME_CHROME_BLANK;
+        if (row_blank(frame[y]))
+        {
+            continue;
+        }
+        for (int i = 0; i < count && row_index[y] == FRAME_CHROME_BLANK; i++)
+        {
+            if (memcmp(frame[stored[i]], frame[y], EPD_BYTE_WIDTH) == 0)
+            {
+                row_index[y] = i;
+            }
+        }
+        if (row_index[y] == FRAME_CHROME_BLANK)
+        {
+            stored[count] = y;
+            row_index[y] = count++;
+        }
+    }
+
+    FILE *file = fopen(argv[1], "w");
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    fprintf(file, "/* Generated by tools/frame_preview/frame_chrome_gen.c from frame_draw_chrome() in src/frame.c, "
+            "do not edit */\n\n");
+    fprintf(file, "#include \"frame_chrome.h\"\n\n");
+    fprintf(file, "const int16_t frame_chrome_index[EPD_HEIGHT] =\n{");
+    for (int y = 0; y < EPD_HEIGHT; y++)
+    {
+        fprintf(file, "%s%d,", ((y % BYTES_PER_LINE) == 0) ? "\n    " : " ", row_index[y]);
+    }
+    fprintf(file, "\n};\n\n");
+    fprintf(file, "/* %d rows, %d bytes where the whole frame would be %d */\n", count, count * EPD_BYTE_WIDTH,
+            EPD_HEIGHT * EPD_BYTE_WIDTH);
+    fprintf(file, "const uint8_t frame_chrome_rows[][EPD_BYTE_WIDTH] =\n{\n");
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(file, "    { // %d", stored[i]);
+        for (int x = 0; x < EPD_BYTE_WIDTH; x++)
+        {
+            fprintf(file, "%s0x%02x,", ((x % BYTES_PER_LINE) == 0) ? "\n        " : " ", frame[stored[i]][x]);
+        }
+        fprintf(file, "\n    },\n");
+    }
+    fprintf(file, "};\n");
+    fclose(file);
+
+    printf("%d of %d rows stored, %d bytes\n", count, EPD_HEIGHT, count * EPD_BYTE_WIDTH);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "display.h"
+#include "frame_diff.h"
+
+/* Runs frame_diff.c over a few wakes of a synthetic frame, a box that moves, and checks that
+ * - with nothing stored the frame is a full refresh, and the hashes it stores are compared on the next wake
+ * - an identical frame comes out unchanged, and a moved box only sends the blocks it left and entered
+ * - a region marked with frame_diff_drawn_over() is sent even when its hashes match, as the ULP's clock is
+ * - bands outside the changed regions are neither rendered nor sent */
+
+static int failures = 0;
+static int bands_rendered = 0;
+static int box_x = 100, box_y = 60; // Top left of a 40x40 box, in pixels
+
+static void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void render_box(uint8_t *band, int top)
+{
+    for (int y = box_y; y < box_y + 40; y++)
+    {
+        if (y >= top && y < top + EPD_BAND_HEIGHT)
+        {
+            memset(&band[((y - top) * EPD_BYTE_WIDTH) + (box_x / BITS_PER_BYTE)], 0xff, 40 / BITS_PER_BYTE);
+        }
+    }
+    bands_rendered++;
+}
+
+static bool rects_cover(const frame_diff_t *diff, int x, int y, int width, int height)
+{
+    for (int i = 0; i < diff->count; i++)
+    {
+        const epd_rect_t *rect = &diff->rects[i];
+        if (rect->x <= x && rect->y <= y && (rect->x + rect->width) >= (x + width)
+                && (rect->y + rect->height) >= (y + height))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(void)
+{
+    frame_diff_t diff;
+    frame_damage_t changed;
+
+    frame_diff_invalidate();
+    expect(frame_diff_compute(render_box, NULL, &diff) == ESP_OK, "first compute");
+    expect(diff.full, "nothing stored is a full refresh");
+    expect(bands_rendered == EPD_HEIGHT / EPD_BAND_HEIGHT, "every band rendered");
+    frame_diff_commit();
+
+    expect(frame_diff_compute(render_box, NULL, &diff) == ESP_OK, "second compute");
+    expect(!diff.full && diff.count == 0, "the same frame is unchanged");
+    frame_diff_commit();
+
+    box_x = 200;
+    box_y = 300;
+    expect(frame_diff_compute(render_box, NULL, &diff) == ESP_OK, "compute after moving the box");
+    expect(!diff.full && diff.count > 0, "a moved box is a partial refresh");
+    expect(rects_cover(&diff, 100, 60, 40, 40), "where the box was is sent");
+    expect(rects_cover(&diff, 200, 300, 40, 40), "where the box is is sent");
+    expect(diff.dirty_pixels < (EPD_WIDTH * EPD_HEIGHT) / 10, "little more than the box is sent");
+    frame_diff_commit();
+
+    frame_diff_drawn_over(CLOCK_X, CLOCK_Y, CLOCK_WIDTH, CLOCK_HEIGHT);
+    expect(frame_diff_compute(render_box, NULL, &diff) == ESP_OK, "compute with the clock drawn over");
+    expect(!diff.full && rects_cover(&diff, CLOCK_X, CLOCK_Y, CLOCK_WIDTH, CLOCK_HEIGHT), "the clock is sent");
+    expect(diff.dirty_pixels == CLOCK_WIDTH * CLOCK_HEIGHT, "only the clock is sent");
+    frame_diff_commit();
+    expect(frame_diff_compute(render_box, NULL, &diff) == ESP_OK, "compute after the clock");
+    expect(!diff.full && diff.count == 0, "the clock is only sent once per mark");
+    frame_diff_commit();
+
+    box_x = 300;
+    frame_damage_reset(&changed);
+    frame_damage_add(&changed, 200, 300, 144, 40);
+    bands_rendered = 0;
+    expect(frame_diff_compute(render_box, &changed, &diff) == ESP_OK, "compute with changed regions");
+    expect(bands_rendered == 2, "only the bands the changed region reaches are rendered");
+    expect(rects_cover(&diff, 200, 300, 40, 40) && rects_cover(&diff, 300, 300, 40, 40), "the moved box is sent");
+    frame_diff_commit();
+
+    frame_diff_invalidate();
+    expect(frame_diff_compute(render_box, &changed, &diff) == ESP_OK, "compute after invalidating");
+    expect(!diff.full && diff.count == 1 && rects_cover(&diff, 200, 300, 144, 40),
+            "without hashes the changed regions are sent as they are");
+
+    if (failures != 0)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("frame_diff: all checks passed\n");
+    return EXIT_SUCCESS;
+}
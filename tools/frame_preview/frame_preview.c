@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "display.h"
+#include "epd.h"
+#include "frame.h"
+
+/* Renders the default frame from fixed weather data on the host and writes it out as a binary PBM, which
+ * like the panel has 1 for black. Bands go through frame_record_default() and frame_render_default()
+ * exactly as they do on the device. See CMakeLists.txt in this directory for how to build it.
+ *
+ * Built with FRAME_BENCHMARK the primitives are timed afterwards, with the CSV results written to the file
+ * given after the image or to stdout */
+
+struct tm timeinfo =
+{
+    .tm_year = 2025 - 1900, .tm_mon = 2, .tm_mday = 5, .tm_wday = 3, // Wednesday, March 05, 2025
+    .tm_hour = 14, .tm_min = 37
+};
+uint8_t battery_percentage = 73;
+struct weather_today weather =
+{
+    .id = 803,
+    .description = "broken clouds",
+    .current_temp = 48.5f,
+    .feels_like_temp = 45.2f,
+    .high_temp = 54,
+    .low_temp = 39.9f,
+    .wind_speed = 11.4f,
+    .wind_direction_degrees = 225,
+    .cloudiness = 75
+};
+struct hourly_forecast hourly_forecast[FORECAST_HOURS] =
+{
+    { 48.5f, 0, "02PM" }, { 50, 0, "03PM" }, { 51.3f, 10, "04PM" }, { 49.8f, 20, "05PM" },
+    { 47, 45, "06PM" }, { 45.1f, 70, "07PM" }, { 43.6f, 85, "08PM" }, { 42.9f, 60, "09PM" },
+    { 42, 35, "10PM" }, { 41.2f, 20, "11PM" }, { 40.5f, 5, "12AM" }, { 39.9f, 0, "01AM" }
+};
+struct weather_forecast forecast[FORECAST_DAYS] =
+{
+    { 803, 54, 39.9f, 85, "Wednesday" },
+    { 500, 47.3f, 36, 90, "Thursday" },
+    { 601, 35, 28.4f, 60, "Friday" },
+    { 800, 41, 25, 0, "Saturday" },
+    { 801, 52.6f, 33, 0, "Sunday" },
+    { 211, 58, 44.1f, 40, "Monday" },
+    { 741, 55, 42, 10, "Tuesday" },
+    { 804, 50, 40, 20, "Wednesday" }
+};
+
+int main(int argc, char *argv[])
+{
+    static uint8_t frame[EPD_HEIGHT][EPD_BYTE_WIDTH];
+
+#if defined(FRAME_BENCHMARK)
+    if (argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <output.pbm> [results.csv]\n", argv[0]);
+#else
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <output.pbm>\n", argv[0]);
+#endif
+        return EXIT_FAILURE;
+    }
+
+    frame_record_default();
+    for (int top = 0; top < EPD_HEIGHT; top += EPD_BAND_HEIGHT)
+    {
+        frame_render_default(frame[top], top);
+    }
+
+    FILE *file = fopen(argv[1], "wb");
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    fprintf(file, "P4\n%d %d\n", EPD_WIDTH, EPD_HEIGHT);
+    fwrite(frame, sizeof(frame), 1, file);
+    if (fclose(file) != 0)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+#if defined(FRAME_BENCHMARK)
+    FILE *results = (argc == 3) ? fopen(argv[2], "w") : stdout;
+    if (results == NULL)
+    {
+        perror(argv[2]);
+        return EXIT_FAILURE;
+    }
+    if (frame_benchmark(results) != ESP_OK || (results != stdout && fclose(results) != 0))
+    {
+        fprintf(stderr, "Benchmark failed\n");
+        return EXIT_FAILURE;
+    }
+#endif
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "display.h"
+#include "epd.h"
+#include "frame.h"
+#include "frame_list.h"
+
+/* Renders the default frame with two threads taking alternate bands at the same time, as core 0 and the
+ * worker on core 1 do on the device, and checks it byte for byte against the same frame rendered by one
+ * thread. Run over 40 sets of inputs, each a few times to give the threads a chance to interleave.
+ *
+ * The frame_render_overflow test runs it built with FRAME_LIST_MAX_OPS too small for the frame, where
+ * frame_render_default() runs the drawing code for every band instead of replaying the list, so both threads
+ * are in the widgets at once */
+
+#define INPUT_SETS 40
+#define REPEATS    20
+
+struct tm timeinfo = { .tm_year = 2025 - 1900, .tm_mon = 2, .tm_mday = 5, .tm_wday = 3, .tm_hour = 14 };
+uint8_t battery_percentage;
+struct weather_today weather = { .id = 803, .description = "broken clouds" };
+struct hourly_forecast hourly_forecast[FORECAST_HOURS];
+struct weather_forecast forecast[FORECAST_DAYS];
+
+static uint8_t expected[EPD_HEIGHT][EPD_BYTE_WIDTH];
+static uint8_t frame[EPD_HEIGHT][EPD_BYTE_WIDTH];
+
+/* Inputs that change with the set, with fractions so float_to_string() has something to format */
+static void inputs_set(int set)
+{
+    static const uint16_t ids[] = { 211, 500, 601, 741, 800, 801, 803, 804 };
+    timeinfo.tm_min = set;
+    battery_percentage = 100 - (set * 2);
+    weather.current_temp = 30.5f + set;
+    weather.feels_like_temp = 28.2f + set;
+    weather.high_temp = 40 + set;
+    weather.low_temp = 20.1f + (set / 2);
+    weather.wind_speed = 0.4f * set;
+    weather.wind_direction_degrees = set * 9;
+    weather.cloudiness = (set * 7) % 101;
+    for (int i = 0; i < FORECAST_HOURS; i++)
+    {
+        hourly_forecast[i].temp = 20.3f + ((set + (i * 7)) % 60);
+        hourly_forecast[i].precipitation_chance = (set * 3 + i * 11) % 101;
+        snprintf(hourly_forecast[i].time, sizeof(hourly_forecast[i].time), "%02d%s", ((set + i) % 12) + 1,
+                (((set + i) / 12) % 2) ? "AM" : "PM");
+    }
+    for (int i = 0; i < FORECAST_DAYS; i++)
+    {
+        forecast[i].id = ids[(set + i) % (sizeof(ids) / sizeof(ids[0]))];
+        forecast[i].high_temp = 50.7f + ((set + i) % 20);
+        forecast[i].low_temp = 30 + ((set * i) % 15);
+        forecast[i].precipitation_chance = ((set + i) * 13) % 101;
+        snprintf(forecast[i].day, sizeof(forecast[i].day), "Day %d", (set + i) % 7);
+    }
+}
+
+static void render_bands(int first)
+{
+    for (int top = first * EPD_BAND_HEIGHT; top < EPD_HEIGHT; top += 2 * EPD_BAND_HEIGHT)
+    {
+        frame_render_default(frame[top], top);
+    }
+}
+
+static void *render_odd_bands(void *arg)
+{
+    (void)arg;
+    render_bands(1);
+    return NULL;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    for (int set = 0; set < INPUT_SETS; set++)
+    {
+        inputs_set(set);
+        frame_record_default();
+        memset(expected, 0, sizeof(expected));
+        for (int top = 0; top < EPD_HEIGHT; top += EPD_BAND_HEIGHT)
+        {
+            frame_render_default(expected[top], top);
+        }
+        for (int repeat = 0; repeat < REPEATS; repeat++)
+        {
+            pthread_t worker;
+            memset(frame, 0, sizeof(frame));
+            if (pthread_create(&worker, NULL, render_odd_bands, NULL) != 0)
+            {
+                perror("pthread_create");
+                return EXIT_FAILURE;
+            }
+            render_bands(0);
+            pthread_join(worker, NULL);
+            if (memcmp(frame, expected, sizeof(frame)) != 0)
+            {
+                fprintf(stderr, "input set %d: bands rendered on two threads differ from one thread\n", set);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    printf("%d input sets rendered on two threads with a list of %d operations, %d differ\n", INPUT_SETS,
+            FRAME_LIST_MAX_OPS, failures);
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
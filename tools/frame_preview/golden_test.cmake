@@ -0,0 +1,32 @@
+# Runs a host build to write files and compares each byte for byte with the copy checked in, under test/golden
+# or src/ for generated sources, used by add_test() in CMakeLists.txt:
+#   cmake -DCOMMAND=<program;args> -DOUTPUT=<files written> -DGOLDEN=<checked in files> -P golden_test.cmake
+# OUTPUT and GOLDEN are lists in the same order. After a change that is meant to alter the output, copy
+# OUTPUT over GOLDEN and commit it with the change
+foreach(var COMMAND OUTPUT GOLDEN)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "golden_test.cmake: ${var} not set")
+    endif()
+endforeach()
+
+list(LENGTH OUTPUT count)
+list(LENGTH GOLDEN golden_count)
+if(NOT count EQUAL golden_count)
+    message(FATAL_ERROR "golden_test.cmake: ${count} outputs but ${golden_count} golden files")
+endif()
+
+file(REMOVE ${OUTPUT})
+execute_process(COMMAND ${COMMAND} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${COMMAND} failed: ${result}")
+endif()
+
+math(EXPR last "${count} - 1")
+foreach(i RANGE ${last})
+    list(GET OUTPUT ${i} output)
+    list(GET GOLDEN ${i} golden)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${output} ${golden} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${output} differs from ${golden}")
+    endif()
+endforeach()
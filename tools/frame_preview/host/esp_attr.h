@@ -0,0 +1,9 @@
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+/* Host stand-in for the ESP-IDF header, there is no IRAM or RTC memory to place anything in */
+#define IRAM_ATTR
+#define RTC_FAST_ATTR
+#define DMA_ATTR
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef ESP_COMPILER_H
+#define ESP_COMPILER_H
+
+/* Host stand-in for the ESP-IDF header */
+#define likely(x)   __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+
+#endif
@@ -0,0 +1,21 @@
+#include <stdint.h>
+#include <time.h>
+
+#ifndef ESP_CPU_H
+#define ESP_CPU_H
+
+/* Host stand-in for the ESP-IDF header. x86 counts time stamp counter ticks, which run at a fixed rate
+ * rather than the core clock, and anything else counts nanoseconds. Either way only the ratios between
+ * benchmarks compare with the device */
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec * 1000000000ull) + now.tv_nsec);
+#endif
+}
+
+#endif
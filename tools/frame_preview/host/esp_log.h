@@ -0,0 +1,10 @@
+#include <stdio.h>
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+/* Host stand-in for the ESP-IDF header, logs go to stderr so they stay out of any image written to stdout */
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) fprintf(stderr, "I (%s) " format "\n", tag, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef SOC_RTC_H
+#define SOC_RTC_H
+
+/* Host stand-in for the ESP-IDF header */
+#define RTC_CLK_CAL_FRACT 19
+
+#endif
@@ -0,0 +1,14 @@
+#include "soc/soc.h"
+
+#ifndef SOC_RTC_CNTL_REG_H
+#define SOC_RTC_CNTL_REG_H
+
+/* Host stand-in for the ESP-IDF header, only the names ulp/clock.c uses */
+#define RTC_CNTL_TIME_UPDATE_REG        0
+#define RTC_CNTL_TIME_UPDATE            0
+#define RTC_CNTL_TIME0_REG              0
+#define RTC_CNTL_TIME1_REG              0
+#define RTC_CNTL_ULP_CP_TIMER_1_REG     0
+#define RTC_CNTL_ULP_CP_TIMER_SLP_CYCLE 0
+
+#endif
@@ -0,0 +1,8 @@
+#include "soc/soc.h"
+
+#ifndef SOC_RTC_IO_REG_H
+#define SOC_RTC_IO_REG_H
+
+/* Host stand-in for the ESP-IDF header, the GPIO set and clear registers are in soc/soc.h with the decoder */
+
+#endif
@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include "epd_bus.h"
+
+#ifndef SOC_SOC_H
+#define SOC_SOC_H
+
+/* Host stand-in for the ESP-IDF header. Registers read as 0 and writes are dropped, apart from the RTC GPIO
+ * set and clear registers, whose pins go to the trace bus' decoder like ulp_riscv_gpio_output_level() */
+#define BIT(n) (1UL << (n))
+
+#define RTC_GPIO_OUT_W1TS_REG    1
+#define RTC_GPIO_OUT_W1TC_REG    2
+#define RTC_GPIO_OUT_DATA_W1TS_S 10
+#define RTC_GPIO_OUT_DATA_W1TC_S 10
+#define RTC_GPIO_PINS            22
+
+static inline void host_reg_write(uint32_t reg, uint32_t value)
+{
+    if (reg != RTC_GPIO_OUT_W1TS_REG && reg != RTC_GPIO_OUT_W1TC_REG)
+    {
+        return;
+    }
+    for (int pin = 0; pin < RTC_GPIO_PINS; pin++)
+    {
+        if (value & (BIT(pin) << RTC_GPIO_OUT_DATA_W1TS_S))
+        {
+            epd_bus_trace_gpio_write(pin, reg == RTC_GPIO_OUT_W1TS_REG);
+        }
+    }
+}
+
+#define REG_WRITE(reg, value)              host_reg_write((reg), (value))
+#define REG_READ(reg)                      0
+#define REG_SET_BIT(reg, bit)              ((void)0)
+#define REG_GET_BIT(reg, bit)              0
+#define REG_SET_FIELD(reg, field, value)   ((void)(value))
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef ULP_RISCV_H
+#define ULP_RISCV_H
+
+/* Host stand-in for the ESP-IDF header, ulp/clock.c includes it but only needs what the other ULP headers have */
+
+#endif
@@ -0,0 +1,30 @@
+#include "epd_bus.h"
+
+#ifndef ULP_RISCV_GPIO_H
+#define ULP_RISCV_GPIO_H
+
+/* Host stand-in for the ESP-IDF header. Pin writes go to the trace bus' decoder, see epd_bus_trace_gpio_write(),
+ * and the panel is never busy */
+typedef enum
+{
+    GPIO_NUM_3  = 3,
+    GPIO_NUM_4  = 4,
+    GPIO_NUM_7  = 7,
+    GPIO_NUM_9  = 9,
+    GPIO_NUM_15 = 15,
+    GPIO_NUM_17 = 17,
+    GPIO_NUM_18 = 18
+} gpio_num_t;
+
+static inline void ulp_riscv_gpio_output_level(gpio_num_t pin, uint8_t level)
+{
+    epd_bus_trace_gpio_write(pin, level);
+}
+
+static inline uint8_t ulp_riscv_gpio_get_level(gpio_num_t pin)
+{
+    (void)pin;
+    return 1;
+}
+
+#endif
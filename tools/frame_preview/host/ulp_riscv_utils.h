@@ -0,0 +1,28 @@
+#include <stdint.h>
+
+#ifndef ULP_RISCV_UTILS_H
+#define ULP_RISCV_UTILS_H
+
+/* Host stand-in for the ESP-IDF header. Delays return straight away and there is no cycle counter, so
+ * anything timed on the ULP reads 0 */
+#define ULP_RISCV_CYCLES_PER_MS 1
+
+static inline void ulp_riscv_delay_cycles(uint32_t cycles)
+{
+    (void)cycles;
+}
+
+static inline uint32_t ulp_riscv_get_cpu_cycles(void)
+{
+    return 0;
+}
+
+static inline void ulp_riscv_timer_stop(void)
+{
+}
+
+static inline void ulp_riscv_wakeup_main_processor(void)
+{
+}
+
+#endif
@@ -0,0 +1,270 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "display.h"
+#include "epd_bus.h"
+#include "fonts.h"
+#include "refresh_policy.h"
+#include "soc/rtc.h"
+
+/* Runs ulp/clock.c for 600 simulated minutes against a model of the panel, built on the trace bus: each wake
+ * is recorded with epd_bus_trace_gpio_write() decoding the ULP's pin writes, then the trace is read back
+ * and applied to the panel's two RAMs. Checks after every wake that
+ * - the clock on the panel shows the time the ULP says it drew, glyph for glyph against font60_table in
+ *   src/fonts.c, including characters that weren't in the window and were left from earlier wakes
+ * - inside each window, TRANSFER_DATA_1 (the old RAM) is the complement of TRANSFER_DATA_2, which the
+ *   partial waveform relies on
+ * It starts at 9:07 with nothing known about the panel and runs past 12:00, where the ULP hands the
+ * AM/PM change to the main CPU, which is modelled as drawing the clock itself. Before that, a wakeup while
+ * the main CPU holds the ULP has to leave the pins and every shared variable alone */
+
+#define MINUTES       600
+#define TRACE_PATH    "ulp_clock.trace"
+#define CHAR_WIDTH    48
+#define CHAR_HEIGHT   85
+#define CHAR_BYTES    (CHAR_WIDTH / BITS_PER_BYTE)
+#define NUM_CHARS     5
+#define CLOCK_BYTES   (NUM_CHARS * CHAR_BYTES)
+
+/* ULP program and the variables the main CPU sees as ulp_* on the device */
+int ulp_clock_main(void);
+extern volatile uint32_t hours, minutes, shown_hours, shown_minutes, clk_cal, wakeups, main_cpu_active, busy;
+extern refresh_policy_t refresh_policy;
+extern const uint8_t font60_table[];
+
+/* Panel state, only the clock's rows are compared but the RAMs cover the whole panel */
+static uint8_t old_ram[EPD_HEIGHT][EPD_BYTE_WIDTH];
+static uint8_t new_ram[EPD_HEIGHT][EPD_BYTE_WIDTH];
+static uint8_t shown[EPD_HEIGHT][EPD_BYTE_WIDTH]; // 1 for black, as drawn by the last refresh of each pixel
+
+typedef struct
+{
+    int command;
+    int params;
+    uint8_t param[9];
+    int left, right, top, bottom; // Window, left and right in bytes
+    int x, y;                     // Next byte of the current transfer
+    bool partial;
+    uint8_t data_polarity;        // DDX bits of VCOM_DATA_INTERVAL, with DDX[0] set new data is 0 for black
+    uint32_t windows, full_refreshes, complement_errors;
+} panel_t;
+
+static panel_t panel = { .right = EPD_BYTE_WIDTH - 1, .bottom = EPD_HEIGHT - 1 };
+
+static void panel_command(uint8_t command)
+{
+    panel.command = command;
+    panel.params = 0;
+    switch (command)
+    {
+        case TRANSFER_DATA_1:
+        case TRANSFER_DATA_2:
+            panel.x = panel.left;
+            panel.y = panel.top;
+            break;
+        case PARTIAL_IN:
+            panel.partial = true;
+            break;
+        case PARTIAL_OUT:
+            panel.partial = false;
+            break;
+        case AUTO_COMMAND:
+            panel.full_refreshes++; // Redraws the panel from RAM it already holds, which changes nothing here
+            break;
+        case DISPLAY_REFRESH:
+            /* Only the window is driven inside PARTIAL_IN, so the rest keeps whatever it showed */
+            panel.windows++;
+            for (int y = panel.top; y <= panel.bottom; y++)
+            {
+                for (int x = panel.left; x <= panel.right; x++)
+                {
+                    shown[y][x] = (panel.data_polarity & 0x01) ? (uint8_t)~new_ram[y][x] : new_ram[y][x];
+                    panel.complement_errors += ((old_ram[y][x] ^ new_ram[y][x]) != 0xFF);
+                }
+            }
+            break;
+    }
+}
+
+static void panel_data(uint8_t data)
+{
+    if (panel.params < (int)sizeof(panel.param))
+    {
+        panel.param[panel.params] = data;
+    }
+    panel.params++;
+    switch (panel.command)
+    {
+        case PARTIAL_WINDOW:
+            if (panel.params == 9)
+            {
+                panel.left = ((panel.param[0] << 8) | panel.param[1]) / BITS_PER_BYTE;
+                panel.right = ((panel.param[2] << 8) | panel.param[3]) / BITS_PER_BYTE;
+                panel.top = (panel.param[4] << 8) | panel.param[5];
+                panel.bottom = (panel.param[6] << 8) | panel.param[7];
+            }
+            break;
+        case VCOM_DATA_INTERVAL:
+            if (panel.params == 1)
+            {
+                panel.data_polarity = data & 0x03;
+            }
+            break;
+        case TRANSFER_DATA_1:
+        case TRANSFER_DATA_2:
+            if (panel.y <= panel.bottom)
+            {
+                uint8_t (*ram)[EPD_BYTE_WIDTH] = (panel.command == TRANSFER_DATA_1) ? old_ram : new_ram;
+                ram[panel.y][panel.x] = data;
+                if (++panel.x > panel.right)
+                {
+                    panel.x = panel.left;
+                    panel.y++;
+                }
+            }
+            break;
+    }
+}
+
+/* Applies a trace written by epd_bus.c, see epd_bus.h for the format */
+static bool panel_apply_trace(const char *path)
+{
+    char line[256];
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        unsigned int byte;
+        int used;
+        if (line[0] == 'C' && sscanf(line + 1, "%x", &byte) == 1)
+        {
+            panel_command(byte);
+        } else if (line[0] == 'D') {
+            for (const char *p = line + 1; sscanf(p, "%x%n", &byte, &used) == 1; p += used)
+            {
+                panel_data(byte);
+            }
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+/* The clock as it should look, from the same table the ULP's font is generated from */
+static void clock_expected(uint32_t hour, uint32_t minute, uint8_t clock[CHAR_HEIGHT][CLOCK_BYTES])
+{
+    const int digits[NUM_CHARS] = { (hour / 10) % 10, hour % 10, -1, (minute / 10) % 10, minute % 10 };
+    for (int i = 0; i < NUM_CHARS; i++)
+    {
+        int glyph = (digits[i] < 0) ? COLON : (digits[i] == 0) ? ZERO : ONE + (digits[i] - 1);
+        for (int row = 0; row < CHAR_HEIGHT; row++)
+        {
+            memcpy(&clock[row][i * CHAR_BYTES], &font60_table[((glyph * CHAR_HEIGHT) + row) * CHAR_BYTES],
+                    CHAR_BYTES);
+        }
+    }
+}
+
+static bool clock_shows(uint32_t hour, uint32_t minute)
+{
+    uint8_t clock[CHAR_HEIGHT][CLOCK_BYTES];
+    clock_expected(hour, minute, clock);
+    for (int row = 0; row < CHAR_HEIGHT; row++)
+    {
+        if (memcmp(clock[row], &shown[CLOCK_Y + row][CLOCK_X / BITS_PER_BYTE], CLOCK_BYTES) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* What the main CPU does when the ULP wakes it at 12:00: draws the whole frame, clock included, and hands
+ * the ULP the next minute */
+static void main_cpu_redraw(void)
+{
+    uint8_t clock[CHAR_HEIGHT][CLOCK_BYTES];
+    clock_expected(12, 0, clock);
+    for (int row = 0; row < CHAR_HEIGHT; row++)
+    {
+        memcpy(&shown[CLOCK_Y + row][CLOCK_X / BITS_PER_BYTE], clock[row], CLOCK_BYTES);
+    }
+    refresh_policy_record(&refresh_policy, REFRESH_FULL, 0, 0, EPD_WIDTH, EPD_HEIGHT);
+    shown_hours = 12;
+    shown_minutes = 0;
+    hours = 12;
+    minutes = 1;
+}
+
+int main(void)
+{
+    uint32_t wrong_clock = 0, main_wakes = 0, data_bytes = 0;
+
+    memset(old_ram, 0xaa, sizeof(old_ram)); // Whatever was left from before the ULP was loaded
+    memset(new_ram, 0x55, sizeof(new_ram));
+    memset(shown, 0xaa, sizeof(shown));
+    refresh_policy_reset(&refresh_policy);
+    clk_cal = 1 << RTC_CLK_CAL_FRACT;
+    wakeups = 1;
+    hours = 9;
+    minutes = 7;
+    shown_hours = 0;
+
+    epd_bus_trace_set_path(TRACE_PATH);
+    if (epd_bus_trace.init() != ESP_OK)
+    {
+        perror(TRACE_PATH);
+        return EXIT_FAILURE;
+    }
+    main_cpu_active = 1;
+    ulp_clock_main();
+    main_cpu_active = 0;
+    const bool held = (epd_bus_stats.data_bytes == 0 && epd_bus_stats.commands == 0 && hours == 9
+            && minutes == 7 && wakeups == 1 && refresh_policy.counts[REFRESH_PARTIAL] == 0 && busy == 0);
+    epd_bus_trace.release();
+    if (!held)
+    {
+        fprintf(stderr, "wakeup while held by the main CPU touched the display or shared state\n");
+    }
+
+    for (int minute = 0; minute < MINUTES; minute++)
+    {
+        const uint32_t hour_before = hours, minute_before = minutes;
+        if (epd_bus_trace.init() != ESP_OK)
+        {
+            perror(TRACE_PATH);
+            return EXIT_FAILURE;
+        }
+        ulp_clock_main();
+        data_bytes += epd_bus_stats.data_bytes;
+        epd_bus_trace.release();
+        if (!panel_apply_trace(TRACE_PATH))
+        {
+            perror(TRACE_PATH);
+            return EXIT_FAILURE;
+        }
+
+        if (minutes == minute_before) // Returned without counting the minute, the main CPU was woken instead
+        {
+            main_cpu_redraw();
+            main_wakes++;
+        } else if (shown_hours != hour_before || shown_minutes != minute_before
+                || !clock_shows(hour_before, minute_before)) {
+            fprintf(stderr, "%02lu:%02lu: clock is wrong\n",
+                    (unsigned long)hour_before, (unsigned long)minute_before);
+            wrong_clock++;
+        }
+    }
+
+    printf("%d minutes: %lu windows, %lu full refreshes, %lu main CPU wakes, %lu data bytes (%lu a minute)\n",
+            MINUTES, (unsigned long)panel.windows, (unsigned long)panel.full_refreshes, (unsigned long)main_wakes,
+            (unsigned long)data_bytes, (unsigned long)(data_bytes / MINUTES));
+    printf("%lu minutes with the wrong clock, %lu window bytes where the old RAM wasn't the complement\n",
+            (unsigned long)wrong_clock, (unsigned long)panel.complement_errors);
+    return (held && wrong_clock == 0 && panel.complement_errors == 0 && main_wakes == 1) ? EXIT_SUCCESS
+        : EXIT_FAILURE;
+}
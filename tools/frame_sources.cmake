@@ -0,0 +1,40 @@
+# Sources the drawing code and the ULP need that are generated from src/ at build time, shared by
+# src/CMakeLists.txt and tools/frame_preview so both draw from the same tables. Appends the generated files
+# to out_var.
+set(frame_tools_dir ${CMAKE_CURRENT_LIST_DIR})
+
+function(frame_generated_sources python source_dir binary_dir out_var)
+    # fonts.c only holds the source tables, the fonts built in are packed from it with blank rows dropped
+    set(font_packed_c ${binary_dir}/font_packed.c)
+    add_custom_command(OUTPUT ${font_packed_c}
+                       COMMAND ${python} ${frame_tools_dir}/font_pack.py
+                               ${source_dir}/fonts.c ${font_packed_c}
+                               font12:font12_table:7:12:font12_table_rotated font16:font16_table:11:16
+                               font20:Font20_Table:14:20 font24:Font24_Table:17:24 font40:Font40_Table:24:40
+                               font60:font60_table:48:85
+                       DEPENDS ${frame_tools_dir}/font_pack.py ${source_dir}/fonts.c
+                       VERBATIM)
+
+    # Rotated copies of the fonts used for rotated text, so it can be blitted like horizontal text
+    set(font_rotated_c ${binary_dir}/font_rotated.c)
+    add_custom_command(OUTPUT ${font_rotated_c}
+                       COMMAND ${python} ${frame_tools_dir}/font_rotate.py
+                               ${source_dir}/fonts.c ${font_rotated_c} font12_table:7:12
+                       DEPENDS ${frame_tools_dir}/font_rotate.py ${source_dir}/fonts.c
+                       VERBATIM)
+
+    set(${out_var} ${${out_var}} ${font_packed_c} ${font_rotated_c} PARENT_SCOPE)
+endfunction()
+
+# The ULP clock's digits and colon, compressed from font60 for the ULP's 8KB. Prints how many bytes that saves.
+# Appends the generated file to out_var
+function(ulp_generated_sources python source_dir binary_dir out_var)
+    set(runs_c ${binary_dir}/ulp_font.c)
+    add_custom_command(OUTPUT ${runs_c}
+                       COMMAND ${python} ${frame_tools_dir}/ulp_font.py
+                               ${source_dir}/fonts.c ${runs_c} font60_table:48:85:11
+                               font60_runs font60_offsets
+                       DEPENDS ${frame_tools_dir}/ulp_font.py ${source_dir}/fonts.c
+                       VERBATIM)
+    set(${out_var} ${${out_var}} ${runs_c} PARENT_SCOPE)
+endfunction()
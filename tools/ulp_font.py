@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Encodes glyphs of a font table in src/fonts.c for the ULP clock, run by src/CMakeLists.txt at build time.
+
+The ULP only has 8KB for everything, so its glyphs are compressed. Each row of a glyph is first XORed with
+the row above it, which leaves little more than the pixels where strokes start or end. The result is read
+row by row, MSB first, as runs: each byte is a run of clear pixels in its upper 6 bits followed by a run of
+set pixels in its lower 2. Rows that don't change XOR to nothing, so a byte without set pixels counts its
+clear pixels in units of 16 instead, and the last one of a glyph may run past its end. ulp/clock.c decodes
+this a byte at a time as it sends the rows.
+
+The size of the same glyphs with the 7-bit RLE the ULP used before, a value bit then a 7-bit run length, is
+printed alongside for comparison.
+
+Usage: ulp_font.py <fonts.c> <output.c> <table>:<width>:<height>:<glyphs> <runs name> <offsets name>
+"""
+
+import re
+import sys
+
+BITS_PER_BYTE = 8
+ZERO_BITS = 6
+ONE_BITS = 2
+MAX_ZEROS = (1 << ZERO_BITS) - 1
+MAX_ONES = (1 << ONE_BITS) - 1
+LONG_ZEROS = 16  # Clear pixels per unit of a byte without set pixels
+
+
+def read_table(source, name):
+    match = re.search(r"\b" + re.escape(name) + r"\s*\[\]\s*=\s*\{(.*?)\};", source, re.S)
+    if match is None:
+        sys.exit(f"ulp_font.py: table {name} not found")
+    body = re.sub(r"//[^\n]*|/\*.*?\*/", "", match.group(1), flags=re.S)
+    return [int(value, 16) for value in re.findall(r"0x[0-9a-fA-F]+", body)]
+
+
+def glyph_pixels(glyph):
+    return [(byte >> (BITS_PER_BYTE - 1 - bit)) & 1 for byte in glyph for bit in range(BITS_PER_BYTE)]
+
+
+def xor_rows(pixels, width):
+    return pixels[:width] + [pixels[i] ^ pixels[i - width] for i in range(width, len(pixels))]
+
+
+def encode(pixels):
+    runs, i = [], 0
+    while i < len(pixels):
+        zeros = 0
+        while i < len(pixels) and pixels[i] == 0:
+            zeros += 1
+            i += 1
+        if i == len(pixels):  # Trailing clear pixels, rounded up
+            while zeros > 0:
+                units = min(-(-zeros // LONG_ZEROS), MAX_ZEROS)
+                runs.append(units << ONE_BITS)
+                zeros -= units * LONG_ZEROS
+            break
+        while zeros > MAX_ZEROS:
+            units = min(zeros // LONG_ZEROS, MAX_ZEROS)
+            runs.append(units << ONE_BITS)
+            zeros -= units * LONG_ZEROS
+        ones = 0
+        while i < len(pixels) and pixels[i] == 1:
+            ones += 1
+            i += 1
+        while ones > 0:
+            runs.append((zeros << ONE_BITS) | min(ones, MAX_ONES))
+            ones -= min(ones, MAX_ONES)
+            zeros = 0
+    return runs
+
+
+def decode(runs, width, count):
+    pixels = []
+    for run in runs:
+        if run & MAX_ONES:
+            pixels += [0] * (run >> ONE_BITS) + [1] * (run & MAX_ONES)
+        else:
+            pixels += [0] * ((run >> ONE_BITS) * LONG_ZEROS)
+    pixels = pixels[:count]
+    for i in range(width, len(pixels)):
+        pixels[i] ^= pixels[i - width]
+    return pixels
+
+
+def plain_rle_size(pixels):
+    size, i = 0, 0
+    while i < len(pixels):
+        run = 1
+        while i + run < len(pixels) and pixels[i + run] == pixels[i] and run < 0x7f:
+            run += 1
+        size += 1
+        i += run
+    return size
+
+
+def main():
+    if len(sys.argv) != 6:
+        sys.exit(__doc__)
+    with open(sys.argv[1]) as f:
+        source = f.read()
+    name, width, height, count = sys.argv[3].split(":")
+    width, height, count = int(width), int(height), int(count)
+    runs_name, offsets_name = sys.argv[4], sys.argv[5]
+    if width % BITS_PER_BYTE != 0:
+        sys.exit(f"ulp_font.py: {name} rows must be whole bytes")
+
+    table = read_table(source, name)
+    glyph_size = (width // BITS_PER_BYTE) * height
+    if len(table) < glyph_size * count:
+        sys.exit(f"ulp_font.py: {name} has fewer than {count} {width}x{height} glyphs")
+
+    out = ["/* Generated by tools/ulp_font.py from src/fonts.c, do not edit */", "",
+           "#include <stdint.h>", "",
+           f"/* {name} glyphs 0 to {count - 1}, each row XORed with the row above then stored as runs of clear",
+           f" * pixels in the upper {ZERO_BITS} bits and set pixels in the lower {ONE_BITS}. Without set pixels",
+           f" * the clear pixels are in units of {LONG_ZEROS} */",
+           f"const uint8_t {runs_name}[] =", "{"]
+    offsets, total, plain_total = [], 0, 0
+    for index in range(count):
+        pixels = glyph_pixels(table[index * glyph_size:(index + 1) * glyph_size])
+        runs = encode(xor_rows(pixels, width))
+        if decode(runs, width, len(pixels)) != pixels:
+            sys.exit(f"ulp_font.py: glyph {index} of {name} doesn't decode to itself")
+        offsets.append(total)
+        total += len(runs)
+        plain_total += plain_rle_size(pixels)
+        out.append(f"    // {index} @{offsets[-1]}")
+        for start in range(0, len(runs), 16):
+            out.append("    " + " ".join(f"0x{run:02x}," for run in runs[start:start + 16]))
+    out.append("};")
+    out.append("")
+    out.append(f"const uint16_t {offsets_name}[] =")
+    out.append("{")
+    out.append("    " + ", ".join(str(offset) for offset in offsets))
+    out.append("};")
+    out.append("")
+
+    # Read back by tools/ulp_size.cmake, which reports it next to the size of the built ULP program
+    out.insert(1, f"/* {total} bytes of runs and {2 * count} of offsets, the 7-bit RLE table they replace "
+                  f"was {plain_total} bytes */")
+
+    with open(sys.argv[2], "w") as f:
+        f.write("\n".join(out))
+    print(f"ulp_font.py: {count} glyphs of {name} in {total} bytes, {plain_total - total} fewer than 7-bit RLE "
+          f"and {glyph_size * count - total} fewer than raw, plus {2 * count} bytes of offsets")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,47 @@
+# Reports how much of the memory reserved for the ULP its program takes, run by src/CMakeLists.txt after the
+# ULP is built:
+#   cmake -DSIZE=<riscv32-esp-elf-size> -DELF=<ULP program> -DFONT=<ulp_font.c> -DRESERVED=<bytes>
+#         -P ulp_size.cmake
+# Code is every .text section, data is everything else loaded (the font is read-only data), and the stack
+# gets whatever is left over
+foreach(var SIZE ELF FONT RESERVED)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "ulp_size.cmake: ${var} not set")
+    endif()
+endforeach()
+
+execute_process(COMMAND ${SIZE} -A ${ELF} OUTPUT_VARIABLE sections RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${SIZE} -A ${ELF} failed: ${result}")
+endif()
+
+set(code 0)
+set(data 0)
+set(bss 0)
+string(REPLACE "\n" ";" lines "${sections}")
+foreach(line ${lines})
+    if(NOT line MATCHES "^(\\.[A-Za-z0-9_.]+) +([0-9]+) +[0-9]+")
+        continue()
+    endif()
+    set(name ${CMAKE_MATCH_1})
+    set(bytes ${CMAKE_MATCH_2})
+    if(name MATCHES "^\\.(comment|debug|riscv\\.attributes|stack)")
+        continue()
+    elseif(name MATCHES "^\\.text")
+        math(EXPR code "${code} + ${bytes}")
+    elseif(name MATCHES "^\\.s?bss")
+        math(EXPR bss "${bss} + ${bytes}")
+    else()
+        math(EXPR data "${data} + ${bytes}")
+    endif()
+endforeach()
+math(EXPR left "${RESERVED} - ${code} - ${data} - ${bss}")
+
+file(STRINGS ${FONT} font_summary REGEX "the 7-bit RLE table they replace")
+if(font_summary MATCHES "([0-9]+) bytes of runs and ([0-9]+) of offsets.* was ([0-9]+) bytes")
+    math(EXPR font "${CMAKE_MATCH_1} + ${CMAKE_MATCH_2}")
+    set(font_note ", ${font} of it the clock font where the 7-bit RLE table was ${CMAKE_MATCH_3}")
+endif()
+
+message("ULP: ${code} bytes of code, ${data} of data${font_note}, ${bss} of variables, "
+        "${left} of ${RESERVED} left for the stack")
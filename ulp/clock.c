@@ -2,66 +2,51 @@
 #include "ulp_riscv_gpio.h"
 #include "ulp_riscv_utils.h"
 #include "soc/rtc_cntl_reg.h"
+#include "soc/rtc_io_reg.h"
 #include "soc/rtc.h"
 #include "../include/display.h"
+#include "../include/fonts.h"
+#include "../include/refresh_policy.h"
 
-/* ULP has 8KB of memory for the code, data, and stack combined, so size is paramount
- * Current size breakdown:
+/* ULP has 8KB of memory for the code, data, and stack combined, so size is paramount. The build reports the
+ * actual sizes after every ULP build, see tools/ulp_size.cmake
+ * Size breakdown when this was written:
  * - Code: 1.7KB
- * - Font data: 1.6KB (RLE compressed data for 0-9, and : characters at 60px size)
- * - Decompressed character buffer: 0.5KB (6 bytes per row * 85 rows)
- * - Frame buffer to hold the current time: 2.5KB ((85 rows * 48 columns * 5 Characters) / 8 bits per byte)
- * - Leftover for stack and variables: ~1.7KB
+ * - Font data: 1KB (0-9, and : characters at 60px size, encoded at build time by tools/ulp_font.py)
+ * - Leftover for stack and variables: ~5.3KB
+ * There is no frame buffer, the characters are decoded as their rows are sent. The leftover has room for
+ * more glyphs, such as AM/PM and the date that the main CPU is still woken up for
  */
 
 #define CHAR_HEIGHT    85
 #define CHAR_WIDTH     48
-#define CHAR_SIZE      ((CHAR_WIDTH * CHAR_HEIGHT) / BITS_PER_BYTE)
 #define NUM_CHARS      5 // HH:MM time format
 
-static const uint8_t font60_table[]; // MSB is the pixel value, lower 7 bits are the run length
-static uint8_t time[CHAR_HEIGHT][(CHAR_WIDTH * NUM_CHARS) / BITS_PER_BYTE];
-static uint8_t dst[CHAR_SIZE];
-
-/* Offsets in font60_table */
-enum
-{
-    ONE         = 0,
-    TWO         = 118,
-    THREE       = 258,
-    FOUR        = 394,
-    FIVE        = 562,
-    SIX         = 700,
-    SEVEN       = 880,
-    EIGHT       = 1002,
-    NINE        = 1202,
-    ZERO        = 1382,
-    COLON       = 1588,
-    TOTAL       = 1657
-};
-/* Sizes of each character's RLE data */
-enum
-{
-    ONESIZE     = TWO   - ONE,
-    TWOSIZE     = THREE - TWO,
-    THREESIZE   = FOUR  - THREE,
-    FOURSIZE    = FIVE  - FOUR,
-    FIVESIZE    = SIX   - FIVE,
-    SIXSIZE     = SEVEN - SIX,
-    SEVENSIZE   = EIGHT - SEVEN,
-    EIGHTSIZE   = NINE  - EIGHT,
-    NINESIZE    = ZERO  - NINE,
-    ZEROSIZE    = COLON - ZERO,
-    COLONSIZE   = TOTAL - COLON
-};
+/* Generated from font60 in src/fonts.c, indexed like it */
+extern const uint8_t font60_runs[];
+extern const uint16_t font60_offsets[];
 
 /* Time variables to track the current wall clock time set by main CPU */
 volatile uint32_t hours     = 0;
 volatile uint32_t minutes   = 0;
 
+/* Time on the display, so only the characters that changed since are sent. The main CPU sets it to the
+ * time it drew, and hours of 0 means what the display shows is unknown */
+volatile uint32_t shown_hours   = 0;
+volatile uint32_t shown_minutes = 0;
+
 /* RTC calibration value calculated by the main CPU */
 volatile uint32_t clk_cal = 0;
 
+/* Shared with the main CPU, which resets it whenever the ULP is loaded */
+refresh_policy_t refresh_policy;
+
+/* Handshake with the main CPU, which sets main_cpu_active before it touches the pins or anything shared here
+ * and then waits for busy to clear. Each side stores its own flag before reading the other's, so either a
+ * wakeup sees main_cpu_active and returns straight away or the main CPU sees busy and waits for it */
+volatile uint32_t main_cpu_active = 0;
+volatile uint32_t busy            = 0;
+
 /* Debug variables to track the state of the ULP program from the main CPU */
 volatile uint32_t wakeups        = 0;
 volatile uint32_t launched       = 0;
@@ -71,6 +56,45 @@ volatile uint32_t epd_started    = 0;
 volatile uint32_t chars_drawn    = 0;
 volatile uint32_t frame_drawn    = 0;
 volatile uint32_t sleep_cycles   = 0;
+volatile uint32_t cycles_per_byte = 0; // Of the last window's data, from bytes_written
+volatile uint32_t baseline_cycles_per_byte = 0; // The same for the per-byte path windows used to take, measured once
+
+/* SPI is bit-banged with the same routines as the main CPU's GPIO bus. MOSI and SCK are clocked with single
+ * stores to the set and clear registers, rather than the read-modify-write ulp_riscv_gpio_output_level() does */
+#define EPD_GPIO_WRITE(pin, level) ulp_riscv_gpio_output_level(pin, level)
+#define EPD_GPIO_SET(pin)   REG_WRITE(RTC_GPIO_OUT_W1TS_REG, BIT(pin) << RTC_GPIO_OUT_DATA_W1TS_S)
+#define EPD_GPIO_CLEAR(pin) REG_WRITE(RTC_GPIO_OUT_W1TC_REG, BIT(pin) << RTC_GPIO_OUT_DATA_W1TC_S)
+#define EPD_BITBANG_BYTE_HOOK() (bytes_written++)
+#include "../include/epd_bitbang.h"
+
+/* Windows used to go out a byte at a time, each bit through ulp_riscv_gpio_output_level() and DC and CS
+ * written around every byte. A few bytes are clocked that way once after the ULP is loaded, with the panel
+ * already asleep after the first window, and timed with the same counter as cycles_per_byte so the device
+ * reports both. CS is written high where that path took it low, which costs the same but leaves the panel
+ * out of it */
+#define BASELINE_BYTES 16
+
+static bool baseline_measured = false; // ULP memory is kept between wakeups, so this is once per load
+
+static void epd_measure_baseline()
+{
+    uint32_t start_cycles = ulp_riscv_get_cpu_cycles();
+    for (int i = 0; i < BASELINE_BYTES; i++)
+    {
+        uint8_t byte = (i & 1) ? 0xaa : 0x55;
+        EPD_GPIO_WRITE(DC_PIN, HIGH);
+        EPD_GPIO_WRITE(CS_PIN, HIGH); // LOW on the old path
+        for (int bit = 0; bit < BITS_PER_BYTE; bit++)
+        {
+            EPD_GPIO_WRITE(MOSI_PIN, (byte & 0x80) ? HIGH : LOW);
+            byte <<= 1;
+            EPD_GPIO_WRITE(SCK_PIN, HIGH);
+            EPD_GPIO_WRITE(SCK_PIN, LOW);
+        }
+        EPD_GPIO_WRITE(CS_PIN, HIGH);
+    }
+    baseline_cycles_per_byte = (ulp_riscv_get_cpu_cycles() - start_cycles) / BASELINE_BYTES;
+}
 
 /* 5 Lut tables consisting of
  *      1       |     6      |     36
@@ -87,63 +111,54 @@ static const uint8_t lut_partial[] =
     0x25, 0x00, 30, 5, 30, 5, 1
 };
 
-/* Decompress the RLE compressed font table */
-void rle_decompress(const uint8_t *src, size_t src_size, size_t bit_count)
+/* Position in a character's runs. Each byte is a run of clear pixels in its upper 6 bits then a run of set
+ * pixels in its lower 2, or without set pixels a run of 16 clear pixels for each, of the character with every
+ * row XORed with the one above. See tools/ulp_font.py */
+typedef struct
 {
-    size_t bit_idx = 0;
-    for (size_t i = 0; i < src_size && bit_idx < bit_count; i++)
+    const uint8_t *src;                        // Next byte of runs
+    uint16_t zeros;                            // Clear pixels left in the current runs
+    uint8_t ones;                              // Set pixels left after them
+    uint8_t col;                               // Byte in the row
+    uint8_t above[CHAR_WIDTH / BITS_PER_BYTE]; // Row above, as decoded
+} glyph_cursor_t;
+
+/* Decodes the next byte of the character, a run at a time rather than a pixel at a time */
+static uint8_t glyph_next_byte(glyph_cursor_t *cursor)
+{
+    uint8_t byte = 0;
+    for (int bits = 0; bits < BITS_PER_BYTE;)
     {
-        int val = (src[i] >> 7) & 1;
-        size_t run = (size_t)(src[i] & 0x7F);
-        for (size_t j = 0; j < run && bit_idx < bit_count; j++)
+        int take;
+        if (cursor->zeros > 0)
         {
-            uint8_t mask = (uint8_t)(1u << (7 - (bit_idx & 7)));
-            if (val)
-            {
-                dst[bit_idx >> 3] |= mask;
-            } else {
-                dst[bit_idx >> 3] &= ~mask;
-            }
-            bit_idx++;
+            take = (cursor->zeros < BITS_PER_BYTE - bits) ? cursor->zeros : BITS_PER_BYTE - bits;
+            cursor->zeros -= take;
+        } else if (cursor->ones > 0) {
+            take = (cursor->ones < BITS_PER_BYTE - bits) ? cursor->ones : BITS_PER_BYTE - bits;
+            byte |= (uint8_t)((0xff >> bits) & ~(0xff >> (bits + take)));
+            cursor->ones -= take;
+        } else {
+            uint8_t runs = *cursor->src++;
+            cursor->ones = runs & 0x03;
+            cursor->zeros = (cursor->ones > 0) ? (runs >> 2) : (runs >> 2) * 16;
+            continue;
         }
+        bits += take;
     }
-}
-
-static void spi_write_byte(uint8_t byte)
-{
-    for (int i = 0; i < BITS_PER_BYTE; i++)
-    {
-        ulp_riscv_gpio_output_level(MOSI_PIN, (byte & 0x80) ? HIGH : LOW);
-        byte <<= 1;
-        ulp_riscv_gpio_output_level(SCK_PIN, HIGH);
-        ulp_riscv_gpio_output_level(SCK_PIN, LOW);
-    }
-    bytes_written++;
-}
-
-static void spi_write_command(uint8_t command)
-{
-    ulp_riscv_gpio_output_level(DC_PIN, LOW);
-    ulp_riscv_gpio_output_level(CS_PIN, LOW);
-    spi_write_byte(command);
-    ulp_riscv_gpio_output_level(CS_PIN, HIGH);
-}
-
-static void spi_write_data(uint8_t data)
-{
-    ulp_riscv_gpio_output_level(DC_PIN, HIGH);
-    ulp_riscv_gpio_output_level(CS_PIN, LOW);
-    spi_write_byte(data);
-    ulp_riscv_gpio_output_level(CS_PIN, HIGH);
+    byte ^= cursor->above[cursor->col];
+    cursor->above[cursor->col] = byte;
+    cursor->col = (cursor->col + 1) % (CHAR_WIDTH / BITS_PER_BYTE);
+    return byte;
 }
 
 static void epd_reset()
 {
-    ulp_riscv_gpio_output_level(RST_PIN, HIGH);
+    EPD_GPIO_WRITE(RST_PIN, HIGH);
     ulp_riscv_delay_cycles(20 * ULP_RISCV_CYCLES_PER_MS);
-    ulp_riscv_gpio_output_level(RST_PIN, LOW);
+    EPD_GPIO_WRITE(RST_PIN, LOW);
     ulp_riscv_delay_cycles(20 * ULP_RISCV_CYCLES_PER_MS);
-    ulp_riscv_gpio_output_level(RST_PIN, HIGH);
+    EPD_GPIO_WRITE(RST_PIN, HIGH);
     ulp_riscv_delay_cycles(20 * ULP_RISCV_CYCLES_PER_MS);
 }
 
@@ -161,54 +176,54 @@ static void epd_init()
 {
     epd_reset();
 
-    spi_write_command(BOOSTER_SOFT_START);
-    spi_write_data(0x17);
-    spi_write_data(0x17);
-    spi_write_data(0x27);
-    spi_write_data(0x17);
+    epd_bitbang_write_command(BOOSTER_SOFT_START);
+    epd_bitbang_write_data(0x17);
+    epd_bitbang_write_data(0x17);
+    epd_bitbang_write_data(0x27);
+    epd_bitbang_write_data(0x17);
 
-    spi_write_command(POWER_SETTING);
-    spi_write_data(0x07);
-    spi_write_data(0x07);
-    spi_write_data(0x3f);
-    spi_write_data(0x3f);
+    epd_bitbang_write_command(POWER_SETTING);
+    epd_bitbang_write_data(0x07);
+    epd_bitbang_write_data(0x07);
+    epd_bitbang_write_data(0x3f);
+    epd_bitbang_write_data(0x3f);
 
-    spi_write_command(PANEL_SETTING);
-    spi_write_data(0x3f);
+    epd_bitbang_write_command(PANEL_SETTING);
+    epd_bitbang_write_data(0x3f);
 
-    spi_write_command(RESOLUTION_SETTING);
-    spi_write_data(0x03);
-    spi_write_data(0x20);
-    spi_write_data(0x01);
-    spi_write_data(0xe0);
+    epd_bitbang_write_command(RESOLUTION_SETTING);
+    epd_bitbang_write_data(0x03);
+    epd_bitbang_write_data(0x20);
+    epd_bitbang_write_data(0x01);
+    epd_bitbang_write_data(0xe0);
 
-    spi_write_command(DUAL_SPI);
-    spi_write_data(0x00);
+    epd_bitbang_write_command(DUAL_SPI);
+    epd_bitbang_write_data(0x00);
 
-    spi_write_command(TCON_SETTING);
-    spi_write_data(0x22);
+    epd_bitbang_write_command(TCON_SETTING);
+    epd_bitbang_write_data(0x22);
 
-    spi_write_command(VCOM_DATA_INTERVAL);
-    spi_write_data(0x39);
-    spi_write_data(0x07);
+    epd_bitbang_write_command(VCOM_DATA_INTERVAL);
+    epd_bitbang_write_data(0x39);
+    epd_bitbang_write_data(0x07);
 
-    spi_write_command(VCOM_DC);
-    spi_write_data(0x26);
+    epd_bitbang_write_command(VCOM_DC);
+    epd_bitbang_write_data(0x26);
 
-    for (int i = 0; i < sizeof(lut_partial); i += PARTIAL_LUT_SIZE)
+    for (int i = 0; i < (int)sizeof(lut_partial); i += PARTIAL_LUT_SIZE)
     {
-        spi_write_command(lut_partial[i]);
+        epd_bitbang_write_command(lut_partial[i]);
         for (int j = 1; j < PARTIAL_LUT_SIZE; j++)
         {
-            spi_write_data(lut_partial[i + j]);
+            epd_bitbang_write_data(lut_partial[i + j]);
         }
         for (int j = PARTIAL_LUT_SIZE; j < FULL_LUT_SIZE; j++)
         {
-            spi_write_data(0x00);
+            epd_bitbang_write_data(0x00);
         }
     }
 
-    spi_write_command(POWER_ON);
+    epd_bitbang_write_command(POWER_ON);
     epd_wait_until_idle();
 
     epd_started = 1;
@@ -216,106 +231,121 @@ static void epd_init()
 
 static void epd_sleep()
 {
-    spi_write_command(POWER_OFF);
+    epd_bitbang_write_command(POWER_OFF);
 }
 
 static void epd_full_refresh()
 {
     epd_reset();
-    spi_write_command(BOOSTER_SOFT_START);
-    spi_write_data(0x17);
-    spi_write_data(0x17);
-    spi_write_data(0x27);
-    spi_write_data(0x17);
-    spi_write_command(AUTO_COMMAND);
-    spi_write_data(0xA5);
+    epd_bitbang_write_command(BOOSTER_SOFT_START);
+    epd_bitbang_write_data(0x17);
+    epd_bitbang_write_data(0x17);
+    epd_bitbang_write_data(0x27);
+    epd_bitbang_write_data(0x17);
+    epd_bitbang_write_command(AUTO_COMMAND);
+    epd_bitbang_write_data(0xA5);
     epd_wait_until_idle();
     epd_sleep();
 }
 
-static void frame_draw_giant_char(uint32_t offset, uint32_t rle_size, uint8_t place)
+/* Characters are 0-9 for digits and 10 for the colon */
+static void glyph_start(glyph_cursor_t *cursor, uint8_t c)
 {
-    const uint8_t *char_start = font60_table + offset;
-    rle_decompress(char_start, rle_size, (CHAR_SIZE * BITS_PER_BYTE));
-    uint8_t x = (place * CHAR_WIDTH) / BITS_PER_BYTE;
-    for (int i = 0; i < CHAR_HEIGHT; i++)
-    {
-        for (int j = 0; j < (CHAR_WIDTH / BITS_PER_BYTE); j++)
-        {
-            time[i][x + j] = dst[j + (i * (CHAR_WIDTH / BITS_PER_BYTE))];
-        }
-    }
-    for (int i = 0; i < CHAR_SIZE; i++)
+    uint8_t glyph = (c == 0) ? ZERO : (c == 10) ? COLON : ONE + (c - 1);
+    cursor->src = font60_runs + font60_offsets[glyph];
+    cursor->zeros = 0;
+    cursor->ones = 0;
+    cursor->col = 0;
+    for (int i = 0; i < (CHAR_WIDTH / BITS_PER_BYTE); i++)
     {
-        dst[i] = 0;
+        cursor->above[i] = 0;
     }
-    chars_drawn++;
 }
 
-static void frame_draw_time(uint32_t hour, uint32_t minute)
+static void time_to_chars(uint32_t hour, uint32_t minute, uint8_t chars[NUM_CHARS])
 {
-    uint8_t time[] =
-    {
-        (hour / 10) % 10,
-        hour % 10,
-        10, // :
-        (minute / 10) % 10,
-        minute % 10
-    };
-    for (int i = 0; i < sizeof(time); i++)
+    chars[0] = (hour / 10) % 10;
+    chars[1] = hour % 10;
+    chars[2] = 10; // :
+    chars[3] = (minute / 10) % 10;
+    chars[4] = minute % 10;
+}
+
+/* Sets the places from first to last inclusive that differ from the time on the display, usually just the last
+ * minute digit. Returns false when the display already shows the time */
+static bool time_changed(const uint8_t chars[NUM_CHARS], int *first, int *last)
+{
+    uint8_t shown[NUM_CHARS];
+    time_to_chars(shown_hours, shown_minutes, shown);
+
+    *first = NUM_CHARS;
+    *last = -1;
+    for (int i = 0; i < NUM_CHARS; i++)
     {
-        uint32_t offset, size;
-        switch (time[i])
+        if (shown_hours == 0 || chars[i] != shown[i])
         {
-            case 0:  offset = ZERO;  size = ZEROSIZE;  break;
-            case 1:  offset = ONE;   size = ONESIZE;   break;
-            case 2:  offset = TWO;   size = TWOSIZE;   break;
-            case 3:  offset = THREE; size = THREESIZE; break;
-            case 4:  offset = FOUR;  size = FOURSIZE;  break;
-            case 5:  offset = FIVE;  size = FIVESIZE;  break;
-            case 6:  offset = SIX;   size = SIXSIZE;   break;
-            case 7:  offset = SEVEN; size = SEVENSIZE; break;
-            case 8:  offset = EIGHT; size = EIGHTSIZE; break;
-            case 9:  offset = NINE;  size = NINESIZE;  break;
-            case 10: offset = COLON; size = COLONSIZE; break;
+            *first = (i < *first) ? i : *first;
+            *last = i;
         }
-        frame_draw_giant_char(offset, size, i);
     }
+    return *last >= 0;
 }
 
-static void epd_write_partial(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+/* Sends the characters in places first to last as one burst of rows, each byte decoded just before it is
+ * clocked out, so no frame buffer is needed */
+static void epd_stream_chars(const uint8_t chars[NUM_CHARS], int first, int last, uint8_t invert)
 {
-    epd_wait_until_idle();
-    spi_write_command(PARTIAL_WINDOW);
-    spi_write_data(x / 256);
-    spi_write_data(x % 256);
-    spi_write_data((x + w - 1) / 256);
-    spi_write_data((x + w - 1) % 256);
-    spi_write_data(y / 256);
-    spi_write_data(y % 256);
-    spi_write_data((y + h - 1) / 256);
-    spi_write_data((y + h - 1) % 256);
-    spi_write_data(0x00);
-
-    spi_write_command(PARTIAL_IN);
-    spi_write_command(TRANSFER_DATA_1);
-    for (int i = 0; i < h; i++)
+    glyph_cursor_t cursors[NUM_CHARS];
+    for (int i = first; i <= last; i++)
     {
-        for (int j = 0; j < (w / 8); j++)
-        {
-            spi_write_data(time[i][j]);
-        }
+        glyph_start(&cursors[i], chars[i]);
     }
-    spi_write_command(TRANSFER_DATA_2);
-    for (int i = 0; i < h; i++)
+    epd_bitbang_begin_data();
+    for (int row = 0; row < CHAR_HEIGHT; row++)
     {
-        for (int j = 0; j < (w / 8); j++)
+        for (int i = first; i <= last; i++)
         {
-            spi_write_data(~time[i][j]);
+            for (int j = 0; j < (CHAR_WIDTH / BITS_PER_BYTE); j++)
+            {
+                epd_bitbang_write_byte(glyph_next_byte(&cursors[i]) ^ invert);
+            }
         }
     }
-    spi_write_command(DISPLAY_REFRESH);
-    spi_write_command(PARTIAL_OUT);
+    epd_bitbang_end_data();
+}
+
+/* Window is places first to last of the clock, a whole number of characters so it stays byte aligned */
+static void epd_write_partial(const uint8_t chars[NUM_CHARS], int first, int last)
+{
+    const uint16_t x = CLOCK_X + (first * CHAR_WIDTH),
+                   y = CLOCK_Y,
+                   w = (last - first + 1) * CHAR_WIDTH,
+                   h = CHAR_HEIGHT;
+    epd_wait_until_idle();
+    epd_bitbang_write_command(PARTIAL_WINDOW);
+    epd_bitbang_write_data(x / 256);
+    epd_bitbang_write_data(x % 256);
+    epd_bitbang_write_data((x + w - 1) / 256);
+    epd_bitbang_write_data((x + w - 1) % 256);
+    epd_bitbang_write_data(y / 256);
+    epd_bitbang_write_data(y % 256);
+    epd_bitbang_write_data((y + h - 1) / 256);
+    epd_bitbang_write_data((y + h - 1) % 256);
+    epd_bitbang_write_data(0x00);
+
+    epd_bitbang_write_command(PARTIAL_IN);
+    /* Each window goes out as one burst with CS held low */
+    uint32_t start_cycles = ulp_riscv_get_cpu_cycles(),
+             start_bytes = bytes_written;
+    epd_bitbang_write_command(TRANSFER_DATA_1);
+    epd_stream_chars(chars, first, last, 0x00);
+    epd_bitbang_write_command(TRANSFER_DATA_2);
+    epd_stream_chars(chars, first, last, 0xff);
+    cycles_per_byte = (ulp_riscv_get_cpu_cycles() - start_cycles) / (bytes_written - start_bytes);
+    chars_drawn += last - first + 1;
+
+    epd_bitbang_write_command(DISPLAY_REFRESH);
+    epd_bitbang_write_command(PARTIAL_OUT);
     epd_wait_until_idle();
     frame_drawn++;
 }
@@ -335,42 +365,67 @@ static uint64_t time_get()
 
 static void rtc_gpio_set_all_low()
 {
-    ulp_riscv_gpio_output_level(MOSI_PIN, LOW);
-    ulp_riscv_gpio_output_level(SCK_PIN, LOW);
-    ulp_riscv_gpio_output_level(CS_PIN, LOW);
-    ulp_riscv_gpio_output_level(DC_PIN, LOW);
-    ulp_riscv_gpio_output_level(RST_PIN, LOW);
+    EPD_GPIO_WRITE(MOSI_PIN, LOW);
+    EPD_GPIO_WRITE(SCK_PIN, LOW);
+    EPD_GPIO_WRITE(CS_PIN, LOW);
+    EPD_GPIO_WRITE(DC_PIN, LOW);
+    EPD_GPIO_WRITE(RST_PIN, LOW);
 }
 
-int main()
+static void clock_wakeup()
 {
     wakeups++;
     if (wakeups == 1) // First wakeup is just to allow main cpu to init variables
     {
         /* Stop the timer to prevent it from waking up the ULP again until the main CPU is ready */
         ulp_riscv_timer_stop();
-        return 0;
+        return;
     }
     if (hours == 0) // AM <-> PM transition handled by main CPU
     {
         ulp_riscv_wakeup_main_processor();
-        return 0;
+        return;
     }
     launched = 1;
     uint64_t start_time = time_get();
 
-    if ((wakeups % 5) == 1)
+    /* Only the characters that changed are sent, a window of whole characters so it stays byte aligned */
+    uint8_t chars[NUM_CHARS];
+    int first, last;
+    refresh_policy_tick(&refresh_policy);
+    time_to_chars(hours, minutes, chars);
+    if (time_changed(chars, &first, &last))
     {
-        epd_full_refresh();
-    }
+        uint16_t x = CLOCK_X + (first * CHAR_WIDTH),
+                 width = (last - first + 1) * CHAR_WIDTH;
+
+        /* Only the full waveform is available here, so anything the policy won't do as a partial becomes full */
+        if (refresh_policy_choose(&refresh_policy, x, CLOCK_Y, width, CHAR_HEIGHT) != REFRESH_PARTIAL)
+        {
+            epd_full_refresh();
+            refresh_policy_record(&refresh_policy, REFRESH_FULL, 0, 0, EPD_WIDTH, EPD_HEIGHT);
+        }
 
-    frame_draw_time(hours, minutes);
+        epd_init();
+        epd_write_partial(chars, first, last);
+        refresh_policy_record(&refresh_policy, REFRESH_PARTIAL, x, CLOCK_Y, width, CHAR_HEIGHT);
+        epd_sleep();
+        if (!baseline_measured)
+        {
+            epd_measure_baseline();
+            baseline_measured = true;
+        }
+        shown_hours = hours;
+        shown_minutes = minutes;
+    }
     minutes = (minutes + 1) % 60; // Increment minutes every wakeup, and roll over to hours after 60
-    hours = (hours + (minutes == 0 ? 1 : 0)) % 12; // Increment hours after 60 minutes, and roll over after 12
+    if (minutes == 0)
+    {
+        /* Hours run 1 to 12, and 11 rolls over to 0 so the next wakeup hands the AM/PM change to the main CPU.
+         * 12 has to go on to 1, rolling it over to 0 as well would wake the main CPU every other minute */
+        hours = (hours == 11) ? 0 : (hours % 12) + 1;
+    }
 
-    epd_init();
-    epd_write_partial(CLOCK_X, CLOCK_Y, (CHAR_WIDTH * NUM_CHARS), CHAR_HEIGHT);
-    epd_sleep();
     rtc_gpio_set_all_low();
 
     /* Calculate execution time and adjust timer to ensure wakeup occurs at the start of every minute */
@@ -387,110 +442,13 @@ int main()
     }
 }
 
-static const uint8_t font60_table[] =
+int main()
 {
-0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0xb, 0x84, 0x29, 0x87, 0x26, 0x8a, 0x23, 0x8d, 0x20, 0x90, 0x1e,
-0x92, 0x1e, 0x8a, 0x4, 0x84, 0x1e, 0x86, 0x8, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c,
-0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c,
-0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c,
-0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c,
-0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c,
-0x84, 0x2c, 0x84, 0x2c, 0x84, 0x2c, 0x84, 0x1e, 0xa0, 0x10, 0xa0, 0x10, 0xa0, 0x7f, 0x7f, 0x7f,
-0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x30, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7, 0x8b, 0x22, 0x90, 0x1f,
-0x93, 0x1b, 0x8a, 0x3, 0x89, 0x19, 0x87, 0xa, 0x87, 0x17, 0x87, 0xd, 0x86, 0x16, 0x85, 0x10,
-0x86, 0x14, 0x86, 0x11, 0x85, 0x13, 0x86, 0x13, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x15,
-0x85, 0x11, 0x84, 0x16, 0x85, 0x11, 0x84, 0x16, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b,
-0x85, 0x2a, 0x86, 0x2a, 0x85, 0x2a, 0x86, 0x29, 0x86, 0x2a, 0x85, 0x2a, 0x86, 0x29, 0x86, 0x29,
-0x86, 0x29, 0x86, 0x29, 0x86, 0x29, 0x86, 0x29, 0x86, 0x29, 0x86, 0x29, 0x86, 0x29, 0x86, 0x29,
-0x86, 0x29, 0x86, 0x28, 0x87, 0x28, 0x87, 0x28, 0x87, 0x28, 0x87, 0x28, 0x87, 0x28, 0x87, 0x28,
-0x87, 0x28, 0x87, 0x28, 0x87, 0x28, 0x87, 0x28, 0x86, 0x16, 0x84, 0xf, 0x86, 0x16, 0x85, 0xf,
-0x85, 0x17, 0x85, 0xf, 0xa1, 0xf, 0xa1, 0xf, 0xa1, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,
-0x7f, 0x31, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7, 0x8c, 0x21, 0x91, 0x1d, 0x95, 0x1a, 0x8a, 0x4,
-0x89, 0x17, 0x88, 0xb, 0x87, 0x16, 0x86, 0xf, 0x86, 0x14, 0x86, 0x11, 0x86, 0x13, 0x85, 0x13,
-0x85, 0x2b, 0x86, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a,
-0x86, 0x2a, 0x85, 0x2a, 0x86, 0x29, 0x86, 0x29, 0x86, 0x26, 0x89, 0x21, 0x8e, 0x21, 0x8e, 0x23,
-0x8d, 0x27, 0x8b, 0x29, 0x88, 0x2a, 0x87, 0x2a, 0x87, 0x2a, 0x87, 0x2a, 0x86, 0x2b, 0x86, 0x2b,
-0x85, 0x2b, 0x85, 0x2b, 0x86, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a,
-0x85, 0x2b, 0x85, 0x2a, 0x86, 0x2a, 0x85, 0x10, 0x85, 0x15, 0x86, 0x10, 0x86, 0x13, 0x86, 0x11,
-0x88, 0xf, 0x87, 0x13, 0x89, 0xc, 0x87, 0x15, 0x8d, 0x3, 0x8a, 0x18, 0x97, 0x1c, 0x92, 0x21,
-0x8c, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0xb, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x3e,
-0x89, 0x27, 0x89, 0x26, 0x8a, 0x26, 0x8a, 0x25, 0x8b, 0x25, 0x85, 0x1, 0x85, 0x24, 0x85, 0x2,
-0x85, 0x24, 0x85, 0x2, 0x85, 0x23, 0x85, 0x3, 0x85, 0x22, 0x86, 0x3, 0x85, 0x22, 0x85, 0x4,
-0x85, 0x21, 0x86, 0x4, 0x85, 0x21, 0x85, 0x5, 0x85, 0x20, 0x86, 0x5, 0x85, 0x20, 0x85, 0x6,
-0x85, 0x1f, 0x85, 0x7, 0x85, 0x1e, 0x86, 0x7, 0x85, 0x1e, 0x85, 0x8, 0x85, 0x1d, 0x86, 0x8,
-0x85, 0x1d, 0x85, 0x9, 0x85, 0x1c, 0x86, 0x9, 0x85, 0x1c, 0x85, 0xa, 0x85, 0x1b, 0x85, 0xb,
-0x85, 0x1b, 0x85, 0xb, 0x85, 0x1a, 0x85, 0xc, 0x85, 0x19, 0x86, 0xc, 0x85, 0x19, 0x85, 0xd,
-0x85, 0x18, 0x86, 0xd, 0x85, 0x18, 0x85, 0xe, 0x85, 0x17, 0x86, 0xe, 0x85, 0x17, 0x85, 0xf,
-0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x9f, 0x11, 0x9f, 0x11, 0x9f, 0x26,
-0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b,
-0x85, 0x2b, 0x85, 0x23, 0x92, 0x1e, 0x92, 0x1e, 0x92, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,
-0x7f, 0x31, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x30, 0x9a, 0x16, 0x9b, 0x15, 0x9a, 0x16, 0x85, 0x2b,
-0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b,
-0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x5, 0x8a, 0x1c, 0x85, 0x2,
-0x8f, 0x1a, 0x98, 0x18, 0x8d, 0x3, 0x89, 0x17, 0x89, 0xa, 0x87, 0x16, 0x86, 0xf, 0x86, 0x15,
-0x85, 0x11, 0x86, 0x2b, 0x85, 0x2b, 0x86, 0x2b, 0x85, 0x2b, 0x85, 0x2c, 0x84, 0x2c, 0x85, 0x2b,
-0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b,
-0x85, 0x2b, 0x85, 0x2a, 0x85, 0x10, 0x84, 0x16, 0x86, 0x10, 0x86, 0x14, 0x85, 0x11, 0x87, 0x12,
-0x86, 0x12, 0x88, 0xe, 0x87, 0x14, 0x89, 0xb, 0x87, 0x17, 0x8b, 0x3, 0x8a, 0x19, 0x96, 0x1d,
-0x91, 0x21, 0x8d, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0xa, 0x7f, 0x7f, 0x7f, 0x7f,
-0x7f, 0x11, 0x8b, 0x22, 0x90, 0x1e, 0x92, 0x1d, 0x8a, 0x3, 0x87, 0x1a, 0x88, 0x9, 0x84, 0x1a,
-0x87, 0x28, 0x87, 0x28, 0x86, 0x29, 0x86, 0x29, 0x86, 0x29, 0x86, 0x2a, 0x85, 0x2a, 0x85, 0x2b,
-0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x84, 0x2b, 0x85, 0x2b,
-0x85, 0x7, 0x8a, 0x1a, 0x85, 0x5, 0x8f, 0x17, 0x85, 0x4, 0x91, 0x16, 0x85, 0x2, 0x89, 0x3,
-0x88, 0x15, 0x85, 0x1, 0x88, 0x8, 0x86, 0x14, 0x85, 0x1, 0x86, 0xb, 0x86, 0x13, 0x8b, 0xd,
-0x86, 0x12, 0x8a, 0xf, 0x85, 0x12, 0x89, 0x11, 0x85, 0x11, 0x88, 0x12, 0x85, 0x11, 0x88, 0x13,
-0x84, 0x11, 0x87, 0x14, 0x84, 0x11, 0x87, 0x14, 0x85, 0x11, 0x85, 0x15, 0x85, 0x11, 0x85, 0x15,
-0x85, 0x11, 0x85, 0x15, 0x85, 0x11, 0x85, 0x15, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14,
-0x84, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x86, 0x11, 0x84, 0x16, 0x85, 0x10,
-0x85, 0x17, 0x85, 0xe, 0x85, 0x18, 0x86, 0xc, 0x86, 0x19, 0x87, 0x8, 0x87, 0x1b, 0x88, 0x3,
-0x89, 0x1d, 0x92, 0x20, 0x8f, 0x23, 0x8a, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x8,
-0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x2c, 0xa0, 0x10, 0xa0, 0x10, 0xa0, 0x10, 0x85, 0x16, 0x85, 0x10,
-0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x11, 0x84, 0x16, 0x85, 0x11, 0x84, 0x15, 0x85, 0x2b,
-0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a,
-0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b,
-0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a,
-0x86, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b,
-0x85, 0x2b, 0x85, 0x2a, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x86, 0x2a, 0x85, 0x2b, 0x85, 0x2b,
-0x84, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x3f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x8,
-0x8a, 0x23, 0x90, 0x1f, 0x92, 0x1d, 0x88, 0x3, 0x89, 0x1b, 0x86, 0xa, 0x86, 0x19, 0x86, 0xc,
-0x86, 0x17, 0x86, 0xe, 0x86, 0x15, 0x86, 0x10, 0x85, 0x15, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12,
-0x85, 0x13, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14,
-0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x13, 0x85, 0x12,
-0x85, 0x14, 0x85, 0x12, 0x85, 0x15, 0x85, 0x10, 0x85, 0x16, 0x86, 0xe, 0x86, 0x17, 0x87, 0xb,
-0x86, 0x19, 0x89, 0x5, 0x88, 0x1b, 0x94, 0x1e, 0x90, 0x1f, 0x92, 0x1c, 0x88, 0x6, 0x88, 0x19,
-0x86, 0xc, 0x86, 0x17, 0x86, 0xe, 0x86, 0x15, 0x86, 0x10, 0x86, 0x14, 0x85, 0x12, 0x85, 0x13,
-0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x84, 0x15, 0x85, 0x11, 0x85, 0x16, 0x85, 0x10,
-0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10,
-0x85, 0x16, 0x85, 0x11, 0x84, 0x15, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x13,
-0x85, 0x12, 0x85, 0x14, 0x86, 0x10, 0x85, 0x16, 0x86, 0xe, 0x86, 0x17, 0x87, 0xa, 0x87, 0x19,
-0x89, 0x4, 0x89, 0x1b, 0x94, 0x1e, 0x90, 0x22, 0x8c, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,
-0x7f, 0xa, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x8, 0x8b, 0x23, 0x8f, 0x20, 0x91, 0x1e, 0x88, 0x3,
-0x89, 0x1b, 0x87, 0x8, 0x87, 0x19, 0x86, 0xc, 0x85, 0x18, 0x86, 0xe, 0x85, 0x17, 0x85, 0x10,
-0x85, 0x15, 0x86, 0x10, 0x85, 0x15, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x13, 0x85, 0x14,
-0x84, 0x13, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x15, 0x84, 0x12, 0x85, 0x15,
-0x85, 0x11, 0x85, 0x15, 0x85, 0x11, 0x85, 0x15, 0x85, 0x11, 0x85, 0x14, 0x86, 0x11, 0x85, 0x14,
-0x86, 0x12, 0x85, 0x12, 0x87, 0x12, 0x85, 0x12, 0x88, 0x11, 0x86, 0x10, 0x89, 0x12, 0x85, 0xf,
-0x8a, 0x12, 0x86, 0xd, 0x8b, 0x13, 0x86, 0xb, 0x8c, 0x14, 0x87, 0x7, 0x88, 0x1, 0x85, 0x15,
-0x88, 0x2, 0x8a, 0x2, 0x85, 0x16, 0x91, 0x4, 0x85, 0x17, 0x8f, 0x5, 0x85, 0x19, 0x8a, 0x8,
-0x85, 0x2b, 0x84, 0x2b, 0x85, 0x2b, 0x85, 0x2b, 0x85, 0x2a, 0x86, 0x2a, 0x85, 0x2b, 0x85, 0x2a,
-0x85, 0x2a, 0x86, 0x2a, 0x85, 0x2a, 0x85, 0x2a, 0x86, 0x29, 0x86, 0x28, 0x87, 0x28, 0x87, 0x1a,
-0x81, 0xc, 0x87, 0x1a, 0x86, 0x4, 0x8b, 0x1b, 0x93, 0x1e, 0x90, 0x21, 0x8c, 0x7f, 0x7f, 0x7f,
-0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x10, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x8, 0x8a, 0x24, 0x8e, 0x20,
-0x92, 0x1d, 0x89, 0x2, 0x89, 0x1b, 0x87, 0x8, 0x87, 0x1a, 0x86, 0xa, 0x86, 0x19, 0x86, 0xc,
-0x86, 0x17, 0x86, 0xe, 0x86, 0x16, 0x85, 0x10, 0x85, 0x15, 0x86, 0x10, 0x85, 0x15, 0x85, 0x12,
-0x85, 0x14, 0x85, 0x12, 0x85, 0x13, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14,
-0x85, 0x12, 0x85, 0x14, 0x85, 0x11, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16,
-0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16,
-0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16,
-0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16,
-0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x85, 0x16, 0x85, 0x10, 0x86, 0x15,
-0x85, 0x11, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x86, 0x12,
-0x86, 0x13, 0x85, 0x12, 0x85, 0x14, 0x85, 0x12, 0x85, 0x15, 0x85, 0x10, 0x86, 0x15, 0x85, 0x10,
-0x85, 0x17, 0x85, 0xe, 0x86, 0x17, 0x86, 0xc, 0x86, 0x19, 0x85, 0xc, 0x85, 0x1a, 0x87, 0x8,
-0x86, 0x1c, 0x89, 0x3, 0x88, 0x1d, 0x92, 0x20, 0x8e, 0x24, 0x8a, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,
-0x7f, 0x7f, 0x7f, 0xb, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0xf,
-0x88, 0x27, 0x8a, 0x25, 0x8c, 0x24, 0x8d, 0x22, 0x8e, 0x22, 0x8e, 0x22, 0x8e, 0x23, 0x8d, 0x23,
-0x8c, 0x25, 0x8a, 0x27, 0x88, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x1d, 0x88, 0x27, 0x8a, 0x25, 0x8c,
-0x24, 0x8d, 0x22, 0x8e, 0x22, 0x8e, 0x22, 0x8e, 0x23, 0x8d, 0x23, 0x8c, 0x25, 0x8a, 0x27, 0x88,
-0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0xc,
-};
+    busy = 1;
+    if (!main_cpu_active)
+    {
+        clock_wakeup();
+    }
+    busy = 0;
+    return 0;
+}